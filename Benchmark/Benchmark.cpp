@@ -0,0 +1,292 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+#include "BenchmarkHarness.h"
+#include "BenchmarkContainers.h"
+
+//Compares sparse_set against the standard containers for every operation, key distribution, value category and size.
+//Run a Release build, results are nanoseconds per operation (per element for iterate and sort).
+
+namespace
+{
+    using namespace Benchmark;
+
+    constexpr std::string_view USAGE{
+        "usage: Benchmark [options]\n"
+        "  --sizes 100,1e4,...      set sizes (default 1e2 to 1e7 in decades)\n"
+        "  --quick                  sizes 1e2 to 1e5 with 3 repetitions\n"
+        "  --warmup N               untimed runs per measurement (default 1)\n"
+        "  --reps N                 timed runs per measurement (default 5)\n"
+        "  --seed N                 seed of the generated keys and values (default 42)\n"
+        "  --ops a,b                emplace, erase, contains, access, iterate, sort, emplace_sorted\n"
+        "  --containers a,b         sparse_set, std::unordered_map, std::map, std::vector<std::optional>\n"
+        "  --values a,b             trivial, non_assignable, assignable\n"
+        "  --distributions a,b      dense, strided, random, clustered\n"
+        "  --max-sorted N           largest size emplace_sorted runs for (default 1e5)\n"
+        "  --max-footprint-mb N     skips key indexed containers that need more memory (default 1024)\n"
+        "  --format table|csv|json  output format (default table)\n"
+        "  --out path               writes the results to a file instead of stdout\n" };
+
+    std::vector<std::string> split(std::string_view list)
+    {
+        std::vector<std::string> items{};
+        while (!list.empty())
+        {
+            size_t const comma{ list.find(',') };
+            items.emplace_back(list.substr(0, comma));
+            list = (comma == std::string_view::npos) ? std::string_view{} : list.substr(comma + 1);
+        }
+        return items;
+    }
+
+    //Accepts scientific notation, 1e6 reads better than 1000000
+    size_t parse_count(const std::string& text)
+    {
+        double const value{ std::stod(text) };
+        if (value < 0)
+        {
+            throw std::invalid_argument{ "negative count " + text };
+        }
+        return static_cast<size_t>(value);
+    }
+
+    template<template<typename> typename Container, typename Val>
+    void run_container(const options& opts, reporter& report, distribution dist, const key_data& data)
+    {
+        using container = Container<Val>;
+
+        if (!selected(opts.containers, container::NAME))
+        {
+            return;
+        }
+        if constexpr (requires { container::footprint(uint32_t{}); })
+        {
+            if (container::footprint(data.maxKey) > opts.maxFootprint)
+            {
+                std::cerr << "skipping " << container::NAME << " " << VALUE_NAME<Val> << " " << to_string(dist) << " " << data.keys.size()
+                          << ": needs " << container::footprint(data.maxKey) / (1024 * 1024) << " MB\n";
+                return;
+            }
+        }
+
+        size_t const count{ data.keys.size() };
+        auto const add = [&](std::string_view operation, const stats& perOp)
+            {
+                report.add({ operation, container::NAME, VALUE_NAME<Val>, to_string(dist), count, perOp });
+            };
+
+        auto const empty = []() { return container{}; };
+        auto const fill = [&data]()
+            {
+                container c{};
+                for (size_t i{ 0 }; i < data.keys.size(); ++i)
+                {
+                    c.emplace(data.keys[i], data.values[i]);
+                }
+                return c;
+            };
+
+        if (selected(opts.operations, "emplace"))
+        {
+            add("emplace", measure_fresh(opts, count, empty, [&data](container& c)
+                {
+                    for (size_t i{ 0 }; i < data.keys.size(); ++i)
+                    {
+                        c.emplace(data.keys[i], data.values[i]);
+                    }
+                }));
+        }
+
+        if (selected(opts.operations, "erase"))
+        {
+            add("erase", measure_fresh(opts, count, fill, [&data](container& c)
+                {
+                    for (uint32_t const key : data.lookups)
+                    {
+                        c.erase(key);
+                    }
+                }));
+        }
+
+        if (selected(opts.operations, "contains") || selected(opts.operations, "access") || selected(opts.operations, "iterate"))
+        {
+            container filled{ fill() };
+
+            if (selected(opts.operations, "contains"))
+            {
+                add("contains", measure(opts, count, filled, [&data](const container& c)
+                    {
+                        size_t hits{ 0 };
+                        for (uint32_t const key : data.queries)
+                        {
+                            hits += c.contains(key) ? size_t{ 1 } : size_t{ 0 };
+                        }
+                        keep(hits);
+                    }));
+            }
+
+            if (selected(opts.operations, "access"))
+            {
+                add("access", measure(opts, count, filled, [&data](const container& c)
+                    {
+                        long long sum{ 0 };
+                        for (uint32_t const key : data.lookups)
+                        {
+                            sum += c.get(key);
+                        }
+                        keep(sum);
+                    }));
+            }
+
+            if (selected(opts.operations, "iterate"))
+            {
+                add("iterate", measure(opts, count, filled, [](const container& c)
+                    {
+                        long long sum{ 0 };
+                        c.each([&sum](const Val& value) { sum += value.integerVal; });
+                        keep(sum);
+                    }));
+            }
+        }
+
+        //Only containers that keep their values in a sequence of their own can be sorted by value
+        if constexpr (requires(container& c) { c.sort(); })
+        {
+            if (selected(opts.operations, "sort"))
+            {
+                add("sort", measure_fresh(opts, count, fill, [](container& c) { c.sort(); }));
+            }
+        }
+
+        if constexpr (requires(container& c) { c.emplace_sorted(uint32_t{}, int{}); })
+        {
+            if (selected(opts.operations, "emplace_sorted") && count <= opts.maxSortedSize)
+            {
+                add("emplace_sorted", measure_fresh(opts, count, empty, [&data](container& c)
+                    {
+                        for (size_t i{ 0 }; i < data.keys.size(); ++i)
+                        {
+                            c.emplace_sorted(data.keys[i], data.values[i]);
+                        }
+                    }));
+            }
+        }
+    }
+
+    template<typename Val>
+    void run_value(const options& opts, reporter& report, distribution dist, const key_data& data)
+    {
+        if (!selected(opts.values, VALUE_NAME<Val>))
+        {
+            return;
+        }
+
+        run_container<sparse_set_container, Val>(opts, report, dist, data);
+        run_container<unordered_map_container, Val>(opts, report, dist, data);
+        run_container<map_container, Val>(opts, report, dist, data);
+        run_container<optional_vector_container, Val>(opts, report, dist, data);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    options opts{};
+    std::string outPath{};
+
+    try
+    {
+        for (int i{ 1 }; i < argc; ++i)
+        {
+            std::string_view const arg{ argv[i] };
+            auto const next = [&]() -> std::string
+                {
+                    if (i + 1 >= argc)
+                    {
+                        throw std::invalid_argument{ "missing value for " + std::string{ arg } };
+                    }
+                    return argv[++i];
+                };
+
+            if (arg == "--sizes")
+            {
+                opts.sizes.clear();
+                for (const std::string& size : split(next()))
+                {
+                    opts.sizes.push_back(parse_count(size));
+                }
+            }
+            else if (arg == "--quick")
+            {
+                opts.sizes = { 100, 1'000, 10'000, 100'000 };
+                opts.repetitions = 3;
+            }
+            else if (arg == "--warmup") { opts.warmup = parse_count(next()); }
+            else if (arg == "--reps") { opts.repetitions = std::max<size_t>(parse_count(next()), 1); }
+            else if (arg == "--seed") { opts.seed = static_cast<uint32_t>(parse_count(next())); }
+            else if (arg == "--ops") { opts.operations = split(next()); }
+            else if (arg == "--containers") { opts.containers = split(next()); }
+            else if (arg == "--values") { opts.values = split(next()); }
+            else if (arg == "--distributions") { opts.distributions = split(next()); }
+            else if (arg == "--max-sorted") { opts.maxSortedSize = parse_count(next()); }
+            else if (arg == "--max-footprint-mb") { opts.maxFootprint = parse_count(next()) * 1024 * 1024; }
+            else if (arg == "--out") { outPath = next(); }
+            else if (arg == "--format")
+            {
+                std::string const format{ next() };
+                if (format == "table") { opts.format = output_format::table; }
+                else if (format == "csv") { opts.format = output_format::csv; }
+                else if (format == "json") { opts.format = output_format::json; }
+                else { throw std::invalid_argument{ "unknown format " + format }; }
+            }
+            else if (arg == "--help" || arg == "-h")
+            {
+                std::cout << USAGE;
+                return 0;
+            }
+            else
+            {
+                throw std::invalid_argument{ "unknown option " + std::string{ arg } };
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n" << USAGE;
+        return 1;
+    }
+
+    std::ofstream file{};
+    if (!outPath.empty())
+    {
+        file.open(outPath);
+        if (!file)
+        {
+            std::cerr << "can not open " << outPath << "\n";
+            return 1;
+        }
+    }
+
+    reporter report{ outPath.empty() ? std::cout : file, opts };
+    for (size_t const size : opts.sizes)
+    {
+        for (distribution const dist : DISTRIBUTIONS)
+        {
+            if (!selected(opts.distributions, to_string(dist)))
+            {
+                continue;
+            }
+
+            key_data const data{ make_key_data(dist, size, opts.seed) };
+            run_value<ComplexType1>(opts, report, dist, data);
+            run_value<ComplexType2>(opts, report, dist, data);
+            run_value<ComplexType3>(opts, report, dist, data);
+        }
+    }
+
+    return 0;
+}
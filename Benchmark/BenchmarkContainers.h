@@ -0,0 +1,310 @@
+#ifndef BENCHMARK_CONTAINERS
+#define BENCHMARK_CONTAINERS
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <random>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#include "SparseSet.h"
+
+namespace Benchmark
+{
+	//The three value categories sparse_set handles differently, same shapes as the ComplexTypes of the tests.
+	//Trivially copyable, erase and sort use memcpy
+	struct ComplexType1 final
+	{
+		int integerVal;
+		bool boolVal = false;
+	};
+
+	//Not assignable, erase and sort destroy and move construct
+	struct ComplexType2 final
+	{
+		const int integerVal;
+		std::string strVal = " ";
+	};
+
+	//Move assignable
+	struct ComplexType3 final
+	{
+		int integerVal;
+		std::string strVal = " ";
+	};
+
+	template<typename Val>
+	inline constexpr std::string_view VALUE_NAME{ };
+	template<>
+	inline constexpr std::string_view VALUE_NAME<ComplexType1>{ "trivial" };
+	template<>
+	inline constexpr std::string_view VALUE_NAME<ComplexType2>{ "non_assignable" };
+	template<>
+	inline constexpr std::string_view VALUE_NAME<ComplexType3>{ "assignable" };
+
+	struct by_value final
+	{
+		template<typename Val>
+		bool operator()(const Val& lhs, const Val& rhs) const noexcept { return lhs.integerVal < rhs.integerVal; }
+	};
+
+	enum class distribution : uint8_t
+	{
+		dense,		//0 .. n-1 in order
+		strided,	//Every KEY_SPREAD-th key in order
+		random,		//Unique keys drawn uniformly from [0, n * KEY_SPREAD) in random order
+		clustered	//Runs of CLUSTER_SIZE consecutive keys at random positions of [0, n * KEY_SPREAD)
+	};
+
+	inline constexpr distribution DISTRIBUTIONS[]{ distribution::dense, distribution::strided, distribution::random, distribution::clustered };
+	inline constexpr uint32_t KEY_SPREAD{ 8 };
+	inline constexpr uint32_t CLUSTER_SIZE{ 64 };
+
+	[[nodiscard]] constexpr std::string_view to_string(distribution dist) noexcept
+	{
+		switch (dist)
+		{
+		case distribution::dense: return "dense";
+		case distribution::strided: return "strided";
+		case distribution::random: return "random";
+		case distribution::clustered: return "clustered";
+		}
+		return "";
+	}
+
+	//Input of every operation for one distribution and size, generated once and shared by all containers
+	struct key_data final
+	{
+		std::vector<uint32_t> keys{ };		//Insertion order
+		std::vector<uint32_t> lookups{ };	//Every key in random order
+		std::vector<uint32_t> queries{ };	//Half keys, half absent keys in random order
+		std::vector<int> values{ };			//Random value per insertion
+		uint32_t maxKey{ 0 };
+	};
+
+	[[nodiscard]] inline key_data make_key_data(distribution dist, size_t count, uint32_t seed)
+	{
+		key_data data{ };
+		std::mt19937 gen{ seed };
+
+		uint32_t const range{ static_cast<uint32_t>(count * KEY_SPREAD) };
+		std::vector<bool> present(range, false);
+
+		//Draws unique random positions in [0, slots)
+		auto const draw = [&gen](size_t amount, uint32_t slots)
+			{
+				std::vector<bool> taken(slots, false);
+				std::vector<uint32_t> drawn{ };
+				drawn.reserve(amount);
+				std::uniform_int_distribution<uint32_t> uniform{ 0, slots - 1 };
+				while (drawn.size() < amount)
+				{
+					uint32_t const slot{ uniform(gen) };
+					if (!taken[slot])
+					{
+						taken[slot] = true;
+						drawn.push_back(slot);
+					}
+				}
+				return drawn;
+			};
+
+		data.keys.reserve(count);
+		switch (dist)
+		{
+		case distribution::dense:
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				data.keys.push_back(static_cast<uint32_t>(i));
+			}
+			break;
+		case distribution::strided:
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				data.keys.push_back(static_cast<uint32_t>(i * KEY_SPREAD));
+			}
+			break;
+		case distribution::random:
+			data.keys = draw(count, range);
+			break;
+		case distribution::clustered:
+			for (uint32_t const cluster : draw((count + CLUSTER_SIZE - 1) / CLUSTER_SIZE, range / CLUSTER_SIZE))
+			{
+				for (uint32_t i{ 0 }; i < CLUSTER_SIZE && data.keys.size() < count; ++i)
+				{
+					data.keys.push_back(cluster * CLUSTER_SIZE + i);
+				}
+			}
+			break;
+		}
+
+		for (uint32_t const key : data.keys)
+		{
+			present[key] = true;
+			data.maxKey = std::max(data.maxKey, key);
+		}
+
+		data.lookups = data.keys;
+		std::shuffle(data.lookups.begin(), data.lookups.end(), gen);
+
+		//Misses come from the holes of the key range, dense keys have none and miss just past the end
+		std::uniform_int_distribution<uint32_t> missKey{ 0, range + static_cast<uint32_t>(count) };
+		data.queries.reserve(count);
+		for (size_t i{ 0 }; i < count; ++i)
+		{
+			if (i % 2 == 0)
+			{
+				data.queries.push_back(data.lookups[i]);
+				continue;
+			}
+
+			uint32_t key{ missKey(gen) };
+			while (key < range && present[key])
+			{
+				key = missKey(gen);
+			}
+			data.queries.push_back(key);
+		}
+		std::shuffle(data.queries.begin(), data.queries.end(), gen);
+
+		std::uniform_int_distribution<int> value{ 0, 1'000'000'000 };
+		data.values.resize(count);
+		std::generate(data.values.begin(), data.values.end(), [&]() { return value(gen); });
+
+		return data;
+	}
+
+	//Containers share one interface so every operation is written once:
+	//emplace, erase, contains, get (integerVal of a present key), each(func(Val const&)) and size.
+	//Containers that keep values in a sortable sequence also have sort and, for assignable values, emplace_sorted.
+	template<typename Val>
+	class sparse_set_container final
+	{
+	public:
+		static constexpr std::string_view NAME{ "sparse_set" };
+
+		void emplace(uint32_t key, int value) { m_Set.emplace(key, value); }
+		void erase(uint32_t key) { m_Set.erase(key); }
+		[[nodiscard]] bool contains(uint32_t key) const noexcept { return m_Set.contains(key); }
+		[[nodiscard]] int get(uint32_t key) const noexcept { return m_Set[key].integerVal; }
+		[[nodiscard]] size_t size() const noexcept { return m_Set.size(); }
+
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			for (const Val& value : m_Set)
+			{
+				func(value);
+			}
+		}
+
+		void sort() { m_Set.sort(by_value{ }); }
+		void emplace_sorted(uint32_t key, int value) requires Internal::Impl::MoveAssignmentVal<Val> { m_Set.emplace_sorted(key, by_value{ }, value); }
+
+	private:
+		Internal::sparse_set<Val> m_Set{ };
+	};
+
+	template<typename Val>
+	class unordered_map_container final
+	{
+	public:
+		static constexpr std::string_view NAME{ "std::unordered_map" };
+
+		void emplace(uint32_t key, int value) { m_Map.emplace(key, Val{ value }); }
+		void erase(uint32_t key) { m_Map.erase(key); }
+		[[nodiscard]] bool contains(uint32_t key) const noexcept { return m_Map.contains(key); }
+		[[nodiscard]] int get(uint32_t key) const { return m_Map.find(key)->second.integerVal; }
+		[[nodiscard]] size_t size() const noexcept { return m_Map.size(); }
+
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			for (const auto& entry : m_Map)
+			{
+				func(entry.second);
+			}
+		}
+
+	private:
+		std::unordered_map<uint32_t, Val> m_Map{ };
+	};
+
+	template<typename Val>
+	class map_container final
+	{
+	public:
+		static constexpr std::string_view NAME{ "std::map" };
+
+		void emplace(uint32_t key, int value) { m_Map.emplace(key, Val{ value }); }
+		void erase(uint32_t key) { m_Map.erase(key); }
+		[[nodiscard]] bool contains(uint32_t key) const noexcept { return m_Map.contains(key); }
+		[[nodiscard]] int get(uint32_t key) const { return m_Map.find(key)->second.integerVal; }
+		[[nodiscard]] size_t size() const noexcept { return m_Map.size(); }
+
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			for (const auto& entry : m_Map)
+			{
+				func(entry.second);
+			}
+		}
+
+	private:
+		std::map<uint32_t, Val> m_Map{ };
+	};
+
+	//Direct indexing by key, the slot array grows to the largest key like a flat sparse array but holds the values inline
+	template<typename Val>
+	class optional_vector_container final
+	{
+	public:
+		static constexpr std::string_view NAME{ "std::vector<std::optional>" };
+
+		//Bytes of the slot array for the key range, too large ranges are skipped
+		[[nodiscard]] static constexpr size_t footprint(uint32_t maxKey) noexcept { return (static_cast<size_t>(maxKey) + 1) * sizeof(std::optional<Val>); }
+
+		void emplace(uint32_t key, int value)
+		{
+			if (key >= m_Slots.size())
+			{
+				m_Slots.resize(static_cast<size_t>(key) + 1);
+			}
+			m_Slots[key].emplace(Val{ value });
+			++m_Size;
+		}
+		void erase(uint32_t key)
+		{
+			m_Slots[key].reset();
+			--m_Size;
+		}
+		[[nodiscard]] bool contains(uint32_t key) const noexcept { return key < m_Slots.size() && m_Slots[key].has_value(); }
+		[[nodiscard]] int get(uint32_t key) const noexcept { return m_Slots[key]->integerVal; }
+		[[nodiscard]] size_t size() const noexcept { return m_Size; }
+
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			for (const std::optional<Val>& slot : m_Slots)
+			{
+				if (slot)
+				{
+					func(*slot);
+				}
+			}
+		}
+
+	private:
+		std::vector<std::optional<Val>> m_Slots{ };
+		size_t m_Size{ 0 };
+	};
+}
+
+#endif
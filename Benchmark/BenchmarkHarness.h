@@ -0,0 +1,201 @@
+#ifndef BENCHMARK_HARNESS
+#define BENCHMARK_HARNESS
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Benchmark
+{
+	enum class output_format : uint8_t
+	{
+		table,
+		csv,
+		json
+	};
+
+	struct options final
+	{
+		std::vector<size_t> sizes{ 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000 };
+		size_t warmup{ 1 };
+		size_t repetitions{ 5 };
+		uint32_t seed{ 42 };
+
+		//Empty lists run everything
+		std::vector<std::string> operations{ };
+		std::vector<std::string> containers{ };
+		std::vector<std::string> values{ };
+		std::vector<std::string> distributions{ };
+
+		//emplace_sorted is quadratic, larger sizes are skipped
+		size_t maxSortedSize{ 100'000 };
+		//Containers whose key indexed storage would need more bytes are skipped
+		size_t maxFootprint{ size_t{ 1 } << 30 };
+
+		output_format format{ output_format::table };
+	};
+
+	[[nodiscard]] inline bool selected(const std::vector<std::string>& filter, std::string_view name)
+	{
+		return filter.empty() || std::find(filter.begin(), filter.end(), name) != filter.end();
+	}
+
+	//Nanoseconds per operation over all repetitions
+	struct stats final
+	{
+		double median{ 0 };
+		double p10{ 0 };
+		double p90{ 0 };
+		double min{ 0 };
+		double max{ 0 };
+		double mean{ 0 };
+	};
+
+	//Linear interpolation between the closest ranks, samples must be sorted
+	[[nodiscard]] inline double percentile(const std::vector<double>& samples, double fraction) noexcept
+	{
+		double const rank{ fraction * static_cast<double>(samples.size() - 1) };
+		size_t const lower{ static_cast<size_t>(rank) };
+		size_t const upper{ std::min(lower + 1, samples.size() - 1) };
+		return samples[lower] + (samples[upper] - samples[lower]) * (rank - static_cast<double>(lower));
+	}
+
+	[[nodiscard]] inline stats summarize(std::vector<double> samples)
+	{
+		if (samples.empty())
+		{
+			return { };
+		}
+
+		std::sort(samples.begin(), samples.end());
+		return { percentile(samples, 0.5), percentile(samples, 0.1), percentile(samples, 0.9), samples.front(), samples.back(),
+				 std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size()) };
+	}
+
+	//Keeps the compiler from dropping work whose result is otherwise unused
+	template<typename T>
+	void keep(const T& value) noexcept
+	{
+		[[maybe_unused]] static volatile T sink{ };
+		sink = value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	//Runs setup() untimed and run(state) timed for every warmup and measured repetition, each repetition gets a fresh state.
+	//Use for operations that change the state.
+	template<typename Setup, typename Run>
+	[[nodiscard]] stats measure_fresh(const options& opts, size_t operations, Setup&& setup, Run&& run)
+	{
+		std::vector<double> samples{ };
+		for (size_t rep{ 0 }; rep < opts.warmup + opts.repetitions; ++rep)
+		{
+			decltype(auto) state = setup();
+
+			auto const start{ std::chrono::steady_clock::now() };
+			run(state);
+			auto const end{ std::chrono::steady_clock::now() };
+
+			if (rep >= opts.warmup)
+			{
+				samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(std::max<size_t>(operations, 1)));
+			}
+		}
+		return summarize(std::move(samples));
+	}
+
+	//Runs run(state) on the same state for every repetition, for operations that only read
+	template<typename State, typename Run>
+	[[nodiscard]] stats measure(const options& opts, size_t operations, State& state, Run&& run)
+	{
+		return measure_fresh(opts, operations, [&state]() -> State& { return state; }, [&run](State& s) { run(s); });
+	}
+
+	struct result final
+	{
+		std::string_view operation;
+		std::string_view container;
+		std::string_view value;
+		std::string_view distribution;
+		size_t size;
+		stats perOp;
+	};
+
+	//Writes every result as soon as it is measured, long runs can be followed and interrupted without losing rows
+	class reporter final
+	{
+	public:
+		reporter(std::ostream& out, const options& opts) :
+			m_Out{ out },
+			m_Opts{ opts }
+		{
+			switch (m_Opts.format)
+			{
+			case output_format::table:
+				m_Out << std::left << std::setw(16) << "operation" << std::setw(28) << "container" << std::setw(16) << "value"
+					  << std::setw(11) << "keys" << std::right << std::setw(10) << "size" << std::setw(12) << "median ns"
+					  << std::setw(12) << "p10 ns" << std::setw(12) << "p90 ns" << "\n";
+				break;
+			case output_format::csv:
+				m_Out << "operation,container,value,distribution,size,repetitions,median_ns,p10_ns,p90_ns,min_ns,max_ns,mean_ns\n";
+				break;
+			case output_format::json:
+				m_Out << "{\n  \"unit\": \"ns/op\",\n  \"warmup\": " << m_Opts.warmup << ",\n  \"repetitions\": " << m_Opts.repetitions
+					  << ",\n  \"seed\": " << m_Opts.seed << ",\n  \"results\": [";
+				break;
+			}
+		}
+
+		~reporter() noexcept
+		{
+			if (m_Opts.format == output_format::json)
+			{
+				m_Out << "\n  ]\n}\n";
+			}
+			m_Out.flush();
+		}
+
+		reporter(const reporter&) = delete;
+		reporter& operator=(const reporter&) = delete;
+
+		void add(const result& row)
+		{
+			stats const& s{ row.perOp };
+			switch (m_Opts.format)
+			{
+			case output_format::table:
+				m_Out << std::left << std::setw(16) << row.operation << std::setw(28) << row.container << std::setw(16) << row.value
+					  << std::setw(11) << row.distribution << std::right << std::setw(10) << row.size << std::fixed << std::setprecision(2)
+					  << std::setw(12) << s.median << std::setw(12) << s.p10 << std::setw(12) << s.p90 << "\n";
+				break;
+			case output_format::csv:
+				m_Out << row.operation << "," << row.container << "," << row.value << "," << row.distribution << "," << row.size << ","
+					  << m_Opts.repetitions << "," << s.median << "," << s.p10 << "," << s.p90 << "," << s.min << "," << s.max << "," << s.mean << "\n";
+				break;
+			case output_format::json:
+				m_Out << (m_First ? "\n" : ",\n") << "    { \"operation\": \"" << row.operation << "\", \"container\": \"" << row.container
+					  << "\", \"value\": \"" << row.value << "\", \"distribution\": \"" << row.distribution << "\", \"size\": " << row.size
+					  << ", \"median_ns\": " << s.median << ", \"p10_ns\": " << s.p10 << ", \"p90_ns\": " << s.p90
+					  << ", \"min_ns\": " << s.min << ", \"max_ns\": " << s.max << ", \"mean_ns\": " << s.mean << " }";
+				break;
+			}
+			m_First = false;
+			m_Out.flush();
+		}
+
+	private:
+		std::ostream& m_Out;
+		const options& m_Opts;
+		bool m_First{ true };
+	};
+}
+
+#endif
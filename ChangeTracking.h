@@ -0,0 +1,175 @@
+#ifndef SPARSE_SET_CHANGE_TRACKING
+#define SPARSE_SET_CHANGE_TRACKING
+
+#include <vector>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <concepts>
+
+#include "InternalAssert.h"
+#include "SparseStorage.h"
+
+//Empty members take no space, MSVC only honours its own spelling of the attribute
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SPARSE_SET_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define SPARSE_SET_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+namespace Internal
+{
+	//Net change of a key since the last snapshot, none marks a key that was added and removed again and is never reported
+	enum class change_kind : uint8_t
+	{
+		none,
+		added,
+		modified,
+		removed
+	};
+
+	namespace Impl
+	{
+		//Default tracker, every hook is empty and the tracker takes no space in the set
+		template<typename KeyType>
+		struct null_change_tracker final
+		{
+			static constexpr bool enabled{ false };
+
+			null_change_tracker() noexcept = default;
+			template<typename Allocator>
+			explicit null_change_tracker(const Allocator&) noexcept { }
+
+			void on_added(KeyType) noexcept { }
+			void on_modified(KeyType) noexcept { }
+			void on_removed(KeyType) noexcept { }
+			void on_reordered() noexcept { }
+		};
+
+		//Journal of the keys that changed since the last snapshot, one entry per key holding its net change.
+		//Entries are found through a hashed key index so repeated changes of a key only update its entry.
+		template<typename KeyType, typename Allocator = std::allocator<KeyType>>
+		class change_journal final
+		{
+			using alloc_traits = std::allocator_traits<Allocator>;
+
+		public:
+			struct entry final
+			{
+				KeyType key;
+				change_kind kind;
+			};
+
+			using entry_container = std::vector<entry, typename alloc_traits::template rebind_alloc<entry>>;
+			using index_storage = hashed_sparse_storage<KeyType, uint32_t, typename alloc_traits::template rebind_alloc<uint32_t>>;
+
+			static constexpr bool enabled{ true };
+
+			change_journal() noexcept = default;
+			explicit change_journal(const Allocator& alloc) noexcept :
+				m_Index(typename index_storage::allocator_type{ alloc }),
+				m_Entries(typename entry_container::allocator_type{ alloc })
+			{ }
+
+		public:
+			void on_added(KeyType key) noexcept { record(key, change_kind::added); }
+			void on_modified(KeyType key) noexcept { record(key, change_kind::modified); }
+			void on_removed(KeyType key) noexcept { record(key, change_kind::removed); }
+			void on_reordered() noexcept { m_Reordered = true; }
+
+		public:
+			//Entries in the order the keys first changed, may contain none entries
+			const entry_container& entries() const noexcept { return m_Entries; }
+
+			//True when the dense order changed through a sort or an insert into a sorted set
+			[[nodiscard]] bool reordered() const noexcept { return m_Reordered; }
+
+			[[nodiscard]] bool empty() const noexcept { return m_Entries.empty() && !m_Reordered; }
+
+			//Calls func(key, change_kind) for every key with a net change
+			template<typename Func>
+			void each(Func&& func) const
+			{
+				for (entry const& change : m_Entries)
+				{
+					if (change.kind != change_kind::none)
+					{
+						func(change.key, change.kind);
+					}
+				}
+			}
+
+			//Starts a new snapshot, keeps the memory for the next one
+			void clear() noexcept
+			{
+				m_Index.clear();
+				m_Entries.clear();
+				m_Reordered = false;
+			}
+
+		private:
+			index_storage m_Index{ };
+			entry_container m_Entries{ };
+			bool m_Reordered{ false };
+
+			void record(KeyType key, change_kind kind) noexcept
+			{
+				uint32_t const index{ m_Index.get(key) };
+				if (index == index_storage::INVALID_INDEX)
+				{
+					ASSERT(m_Entries.size() < index_storage::INVALID_INDEX, "Too many changes in one snapshot!");
+					m_Index.emplace(key, static_cast<uint32_t>(m_Entries.size()));
+					m_Entries.push_back(entry{ key, kind });
+					return;
+				}
+
+				m_Entries[index].kind = merge(m_Entries[index].kind, kind);
+			}
+
+			//Folds a new change into the net change of a key
+			[[nodiscard]] static constexpr change_kind merge(change_kind current, change_kind next) noexcept
+			{
+				switch (next)
+				{
+				case change_kind::added:
+					return current == change_kind::removed ? change_kind::modified : change_kind::added;
+				case change_kind::modified:
+					return current == change_kind::added ? change_kind::added : change_kind::modified;
+				case change_kind::removed:
+					return current == change_kind::added ? change_kind::none : change_kind::removed;
+				default:
+					return current;
+				}
+			}
+		};
+
+		template<typename P, typename K>
+		concept ChangeTrackingPolicy = requires(typename P::template tracker_type<K, std::allocator<K>> tracker, K key)
+		{
+			{ tracker.enabled } -> std::convertible_to<bool>;
+			tracker.on_added(key);
+			tracker.on_modified(key);
+			tracker.on_removed(key);
+			tracker.on_reordered();
+		};
+	}
+
+	//Change tracking policies, select whether sparse_set records which keys changed.
+
+	//No tracking (default), costs nothing.
+	struct no_change_tracking final
+	{
+		template<typename KeyType, typename Allocator>
+		using tracker_type = Impl::null_change_tracker<KeyType>;
+	};
+
+	//Records the net change of every key that was added, modified through patch / mark_dirty or removed, and whether the set was reordered.
+	//Writes through operator[], iterators or the parallel members are not seen, use patch or mark_dirty for those.
+	struct track_changes final
+	{
+		template<typename KeyType, typename Allocator>
+		using tracker_type = Impl::change_journal<KeyType, Allocator>;
+	};
+}
+
+#endif
@@ -0,0 +1,345 @@
+#ifndef COMMAND_BUFFER
+#define COMMAND_BUFFER
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <tuple>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	template<Impl::ValType Val, Impl::KeyType KeyType>
+	class command_queue;
+
+	enum class command_kind : uint8_t
+	{
+		emplace,	//Emplaces the value unless the key is in the set at that point
+		replace,	//Emplaces the value or overwrites the current one
+		erase		//Erases the key if it is in the set at that point
+	};
+
+	//What a flush did to the target set
+	struct command_flush_result final
+	{
+		size_t emplaced{ 0 };
+		size_t replaced{ 0 };
+		size_t erased{ 0 };
+	};
+
+	namespace Impl
+	{
+		[[nodiscard]] inline uint64_t next_command_queue_id() noexcept
+		{
+			static std::atomic<uint64_t> nextId{ 0 };
+			return nextId.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+	}
+
+	//Records emplace, replace and erase commands against a sparse_set without touching it, see command_queue.
+	//Values are constructed when recorded. A buffer is only ever written by one thread at a time
+	//and keeps its capacity when it is flushed, so a buffer that is reused every frame stops allocating.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t>
+	class command_buffer final
+	{
+	public:
+		command_buffer() noexcept = default;
+
+		template<typename... Args>
+		requires std::is_constructible_v<Val, Args...>
+		void emplace(KeyType key, Args&&... args)
+		{
+			record(key, command_kind::emplace, std::forward<Args>(args)...);
+		}
+
+		template<typename... Args>
+		requires std::is_constructible_v<Val, Args...>
+		void replace(KeyType key, Args&&... args)
+		{
+			record(key, command_kind::replace, std::forward<Args>(args)...);
+		}
+
+		void erase(KeyType key)
+		{
+			ASSERT(key != std::numeric_limits<KeyType>::max(), "Element must be a valid index!");
+			m_Commands.push_back({ key, command_kind::erase, NO_VALUE });
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return m_Commands.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_Commands.empty(); }
+
+		//Drops every recorded command, the memory is kept for the next commands
+		void clear() noexcept
+		{
+			m_Commands.clear();
+			m_Values.clear();
+		}
+
+	private:
+		friend class command_queue<Val, KeyType>;
+
+		static constexpr size_t NO_VALUE{ std::numeric_limits<size_t>::max() };
+
+		struct command final
+		{
+			KeyType key;
+			command_kind kind;
+			size_t value;
+		};
+
+		std::vector<command> m_Commands{ };
+		std::vector<Val> m_Values{ };
+
+		template<typename... Args>
+		void record(KeyType key, command_kind kind, Args&&... args)
+		{
+			ASSERT(key != std::numeric_limits<KeyType>::max(), "Element must be a valid index!");
+			m_Values.emplace_back(std::forward<Args>(args)...);
+			m_Commands.push_back({ key, kind, m_Values.size() - 1 });
+		}
+	};
+
+	//Pool of command buffers that parallel jobs record into while the target set is read or iterated, applied at a sync point with flush.
+	//buffer(index) hands out a fixed buffer per job or chunk index, local() a buffer per calling thread that is created on first use.
+	//Recording into different buffers needs no synchronisation, flush must not run while a buffer is recorded into.
+	//
+	//flush resolves every key on its own: its commands are replayed in buffer order (indexed buffers first, then the thread buffers
+	//in the order the threads first asked for one) and in recording order within a buffer, starting from the state of the key in the set.
+	//The result is independent of the thread timing as long as conflicting commands for one key are recorded into indexed buffers.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t>
+	class command_queue final
+	{
+	public:
+		using buffer_type = command_buffer<Val, KeyType>;
+
+		explicit command_queue(size_t bufferCount = 0) :
+			m_Indexed(bufferCount)
+		{ }
+
+		~command_queue() noexcept = default;
+
+		//Threads cache a pointer to their buffer, so the queue stays where it is
+		command_queue(const command_queue&) = delete;
+		command_queue& operator=(const command_queue&) = delete;
+		command_queue(command_queue&&) = delete;
+		command_queue& operator=(command_queue&&) = delete;
+
+	public:
+		[[nodiscard]] buffer_type& buffer(size_t index) noexcept
+		{
+			ASSERT(index < m_Indexed.size(), "Buffer index out of range!");
+			return m_Indexed[index];
+		}
+
+		[[nodiscard]] size_t buffer_count() const noexcept { return m_Indexed.size(); }
+
+		//Changes the amount of indexed buffers, must not run while a buffer is recorded into. Dropped buffers lose their commands.
+		void resize(size_t bufferCount)
+		{
+			m_Indexed.resize(bufferCount);
+		}
+
+		//Buffer of the calling thread, only the first call of a thread takes a lock
+		[[nodiscard]] buffer_type& local()
+		{
+			struct local_cache
+			{
+				uint64_t queue{ 0 };
+				buffer_type* buffer{ nullptr };
+			};
+			thread_local local_cache cache{ };
+
+			if (cache.queue != m_Id)
+			{
+				std::scoped_lock const lock{ m_LocalMutex };
+
+				std::thread::id const thread{ std::this_thread::get_id() };
+				auto it{ std::find_if(m_Local.begin(), m_Local.end(), [thread](const local_buffer& local) { return local.owner == thread; }) };
+				if (it == m_Local.end())
+				{
+					it = m_Local.insert(m_Local.end(), local_buffer{ thread, { } });
+				}
+
+				cache = { m_Id, &it->buffer };
+			}
+
+			return *cache.buffer;
+		}
+
+		//Amount of recorded commands over all buffers
+		[[nodiscard]] size_t size() const noexcept
+		{
+			size_t count{ 0 };
+			for_each_buffer([&count](const buffer_type& buffer) { count += buffer.size(); });
+			return count;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		//Drops every recorded command without applying it
+		void clear() noexcept
+		{
+			for_each_buffer([](buffer_type& buffer) { buffer.clear(); });
+		}
+
+	public:
+		//Applies every recorded command to the set and clears the buffers.
+		//Each key ends up in the state its commands lead to, the set is then changed with one erase_many and one emplace_bulk,
+		//keys that stay in the set get their last recorded value moved in place.
+		template<Impl::SparsePolicy<KeyType> SparsePolicy, typename Allocator, Impl::KeyType DenseIndex, Impl::ChangeTrackingPolicy<KeyType> ChangeTracking,
+				 Impl::StatsPolicy Stats>
+		command_flush_result flush(sparse_set<Val, KeyType, SparsePolicy, Allocator, DenseIndex, ChangeTracking, Stats>& set)
+		{
+			m_Sources.clear();
+			m_Order.clear();
+			for_each_buffer([this](buffer_type& buffer)
+				{
+					for (size_t i{ 0 }; i < buffer.m_Commands.size(); ++i)
+					{
+						m_Order.push_back({ buffer.m_Commands[i].key, m_Sources.size(), i });
+					}
+					m_Sources.push_back(&buffer);
+				});
+
+			std::sort(m_Order.begin(), m_Order.end(), [](const command_ref& lhs, const command_ref& rhs)
+				{
+					return std::tie(lhs.key, lhs.source, lhs.command) < std::tie(rhs.key, rhs.source, rhs.command);
+				});
+
+			command_flush_result result{ };
+			for (size_t first{ 0 }, last{ 0 }; first < m_Order.size(); first = last)
+			{
+				KeyType const key{ m_Order[first].key };
+				bool const existed{ set.contains(key) };
+
+				//Replay the commands of the key, a null value keeps the value that is in the set
+				bool present{ existed };
+				Val* value{ nullptr };
+				for (last = first; last < m_Order.size() && m_Order[last].key == key; ++last)
+				{
+					buffer_type& source{ *m_Sources[m_Order[last].source] };
+					auto const& command{ source.m_Commands[m_Order[last].command] };
+
+					switch (command.kind)
+					{
+					case command_kind::emplace:
+						if (!present)
+						{
+							present = true;
+							value = &source.m_Values[command.value];
+						}
+						break;
+					case command_kind::replace:
+						present = true;
+						value = &source.m_Values[command.value];
+						break;
+					case command_kind::erase:
+						present = false;
+						value = nullptr;
+						break;
+					}
+				}
+
+				if (!present)
+				{
+					if (existed)
+					{
+						m_EraseKeys.push_back(key);
+					}
+				}
+				else if (!existed)
+				{
+					m_EmplaceKeys.push_back(key);
+					m_EmplaceValues.push_back(std::move(*value));
+				}
+				else if (value)
+				{
+					if constexpr (requires { set.patch(key); })
+					{
+						Impl::assign_value(set.patch(key), std::move(*value));
+					}
+					else
+					{
+						Impl::assign_value(set[key], std::move(*value));
+					}
+					++result.replaced;
+				}
+			}
+
+			result.erased = set.erase_many(m_EraseKeys);
+			result.emplaced = m_EmplaceKeys.size();
+			set.emplace_bulk(m_EmplaceKeys, m_EmplaceValues);
+
+			m_EraseKeys.clear();
+			m_EmplaceKeys.clear();
+			m_EmplaceValues.clear();
+			clear();
+
+			return result;
+		}
+
+	private:
+		struct local_buffer final
+		{
+			std::thread::id owner;
+			buffer_type buffer;
+		};
+
+		//Position of one command, sorted by key and then by recording order
+		struct command_ref final
+		{
+			KeyType key;
+			size_t source;
+			size_t command;
+		};
+
+		uint64_t const m_Id{ Impl::next_command_queue_id() };
+
+		std::vector<buffer_type> m_Indexed;
+		std::deque<local_buffer> m_Local{ };
+		std::mutex m_LocalMutex{ };
+
+		//Flush scratch, kept between flushes so flushing does not allocate once it is warm
+		std::vector<buffer_type*> m_Sources{ };
+		std::vector<command_ref> m_Order{ };
+		std::vector<KeyType> m_EraseKeys{ };
+		std::vector<KeyType> m_EmplaceKeys{ };
+		std::vector<Val> m_EmplaceValues{ };
+
+		template<typename Func>
+		void for_each_buffer(Func&& func)
+		{
+			for (buffer_type& buffer : m_Indexed)
+			{
+				func(buffer);
+			}
+			for (local_buffer& local : m_Local)
+			{
+				func(local.buffer);
+			}
+		}
+		template<typename Func>
+		void for_each_buffer(Func&& func) const
+		{
+			for (const buffer_type& buffer : m_Indexed)
+			{
+				func(buffer);
+			}
+			for (const local_buffer& local : m_Local)
+			{
+				func(local.buffer);
+			}
+		}
+	};
+}
+
+#endif
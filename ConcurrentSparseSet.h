@@ -0,0 +1,659 @@
+#ifndef CONCURRENT_SPARSE_SET
+#define CONCURRENT_SPARSE_SET
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	namespace Impl
+	{
+		//Epoch based reclamation for one writer and a fixed number of reader slots.
+		//Readers announce the epoch they start reading in, the writer tags everything it unlinks with the epoch it retired it in
+		//and only frees it once every active reader announced a later epoch. Readers never wait, only the writer scans the slots.
+		class epoch_domain final
+		{
+		public:
+			explicit epoch_domain(size_t maxReaders) :
+				m_Slots{ std::make_unique<reader_slot[]>(maxReaders) },
+				m_SlotCount{ maxReaders }
+			{ }
+
+			epoch_domain(const epoch_domain&) = delete;
+			epoch_domain& operator=(const epoch_domain&) = delete;
+
+		public:
+			//Claims a free slot for a new reader, throws when every slot is taken
+			[[nodiscard]] size_t acquire_slot()
+			{
+				for (size_t slot{ 0 }; slot < m_SlotCount; ++slot)
+				{
+					bool expected{ false };
+					if (!m_Slots[slot].claimed.load(std::memory_order_relaxed)
+						&& m_Slots[slot].claimed.compare_exchange_strong(expected, true, std::memory_order_acquire))
+					{
+						return slot;
+					}
+				}
+				throw std::length_error{ "Too many readers registered at once" };
+			}
+
+			void release_slot(size_t slot) noexcept
+			{
+				ASSERT(m_Slots[slot].epoch.load(std::memory_order_relaxed) == 0, "Reader released while reading!");
+				m_Slots[slot].claimed.store(false, std::memory_order_release);
+			}
+
+			[[nodiscard]] size_t reader_count() const noexcept
+			{
+				size_t count{ 0 };
+				for (size_t slot{ 0 }; slot < m_SlotCount; ++slot)
+				{
+					count += m_Slots[slot].claimed.load(std::memory_order_relaxed) ? 1 : 0;
+				}
+				return count;
+			}
+
+			//The fence pairs with the one in safe_epoch: either the writer sees the announcement or the reader sees every unlink before it
+			void enter(size_t slot) noexcept
+			{
+				m_Slots[slot].epoch.store(m_Epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+
+			void exit(size_t slot) noexcept
+			{
+				m_Slots[slot].epoch.store(0, std::memory_order_release);
+			}
+
+			//Tags something the writer just unlinked
+			[[nodiscard]] uint64_t retire() noexcept
+			{
+				return m_Epoch.fetch_add(1, std::memory_order_seq_cst);
+			}
+
+			//Everything retired with a tag below the returned epoch is out of reach of every reader
+			[[nodiscard]] uint64_t safe_epoch() const noexcept
+			{
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				uint64_t safe{ m_Epoch.load(std::memory_order_relaxed) };
+				for (size_t slot{ 0 }; slot < m_SlotCount; ++slot)
+				{
+					uint64_t const epoch{ m_Slots[slot].epoch.load(std::memory_order_acquire) };
+					if (epoch != 0)
+					{
+						safe = std::min(safe, epoch);
+					}
+				}
+				return safe;
+			}
+
+		private:
+			//Padded to a cache line so readers do not invalidate each other's slots
+			struct reader_slot final
+			{
+				std::atomic<uint64_t> epoch{ 0 };
+				std::atomic<bool> claimed{ false };
+				char padding[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>) - sizeof(std::atomic<bool>)]{ };
+			};
+
+			std::unique_ptr<reader_slot[]> m_Slots;
+			size_t m_SlotCount;
+
+			//0 marks an inactive reader slot
+			std::atomic<uint64_t> m_Epoch{ 1 };
+		};
+
+		enum class slot_state : uint8_t
+		{
+			free,
+			live,
+			retired
+		};
+
+		//One published generation of the arrays of a concurrent_sparse_set.
+		//Readers only touch the sparse and dense arrays through atomics and only read values the writer no longer changes.
+		template<typename Val, typename KeyType>
+		struct concurrent_version final
+		{
+			static constexpr KeyType INVALID{ std::numeric_limits<KeyType>::max() };
+
+			concurrent_version(size_t sparseCapacity, size_t capacity) :
+				sparse{ std::make_unique<std::atomic<KeyType>[]>(sparseCapacity) },
+				dense{ std::make_unique<std::atomic<KeyType>[]>(capacity) },
+				states{ std::make_unique<slot_state[]>(capacity) },
+				values{ std::allocator<Val>{ }.allocate(capacity) },
+				sparseCapacity{ sparseCapacity },
+				capacity{ capacity }
+			{
+				for (size_t i{ 0 }; i < sparseCapacity; ++i)
+				{
+					sparse[i].store(INVALID, std::memory_order_relaxed);
+				}
+				for (size_t i{ 0 }; i < capacity; ++i)
+				{
+					dense[i].store(INVALID, std::memory_order_relaxed);
+				}
+			}
+
+			//Only runs once no reader can reach the version anymore
+			~concurrent_version() noexcept
+			{
+				if constexpr (!std::is_trivially_destructible_v<Val>)
+				{
+					for (size_t slot{ 0 }; slot < size.load(std::memory_order_relaxed); ++slot)
+					{
+						if (states[slot] != slot_state::free)
+						{
+							std::destroy_at(values + slot);
+						}
+					}
+				}
+				std::allocator<Val>{ }.deallocate(values, capacity);
+			}
+
+			concurrent_version(const concurrent_version&) = delete;
+			concurrent_version& operator=(const concurrent_version&) = delete;
+
+			std::unique_ptr<std::atomic<KeyType>[]> sparse;
+			std::unique_ptr<std::atomic<KeyType>[]> dense;
+			//Writer only
+			std::unique_ptr<slot_state[]> states;
+			Val* values;
+
+			size_t sparseCapacity;
+			size_t capacity;
+			//Slots in use including the retired and free ones, readers iterate up to it
+			std::atomic<size_t> size{ 0 };
+		};
+	}
+
+	//Sparse set for one writer thread and any number of reader threads, reads are wait-free and never block the writer.
+	//The writer never changes a value a reader can reach: updates go through a copy in a new slot (patch, assign),
+	//erased and replaced slots are only reused once every reader that could have seen them is done (see Impl::epoch_domain),
+	//and growing publishes a new version of the arrays while readers finish on the old one.
+	//Readers register once per thread (make_reader) and pin the set while they read, a reader that stays pinned holds back reclamation.
+	//Erased slots leave holes in the dense order until they are reused or the set grows or compacts, iteration skips them.
+	//Iterating readers see every element that is not written during the pass, written elements can be seen twice or not at all.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t>
+	requires std::is_copy_constructible_v<Val>
+	class concurrent_sparse_set final
+	{
+		using version = Impl::concurrent_version<Val, KeyType>;
+		using slot_state = Impl::slot_state;
+
+	public:
+		class reader;
+		class read_guard;
+
+		using key_type = KeyType;
+		using value_type = Val;
+
+		static constexpr size_t DEFAULT_MAX_READERS{ 64 };
+
+		//maxReaders is the number of readers that can be registered at once, the writer scans all of them when it reclaims
+		explicit concurrent_sparse_set(size_t maxReaders = DEFAULT_MAX_READERS) :
+			m_Epochs{ std::max<size_t>(maxReaders, 1) },
+			m_Version{ new version{ 0, 0 } }
+		{ }
+
+		~concurrent_sparse_set() noexcept
+		{
+			ASSERT(m_Epochs.reader_count() == 0, "Readers must be destroyed before the set!");
+			delete m_Version.load(std::memory_order_relaxed);
+		}
+
+		concurrent_sparse_set(const concurrent_sparse_set&) = delete;
+		concurrent_sparse_set& operator=(const concurrent_sparse_set&) = delete;
+		concurrent_sparse_set(concurrent_sparse_set&&) = delete;
+		concurrent_sparse_set& operator=(concurrent_sparse_set&&) = delete;
+
+	public:
+		//Registration of one reader thread, do not share it between threads
+		class reader final
+		{
+		public:
+			~reader() noexcept
+			{
+				if (m_Set)
+				{
+					m_Set->m_Epochs.release_slot(m_Slot);
+				}
+			}
+
+			reader(const reader&) = delete;
+			reader& operator=(const reader&) = delete;
+
+			reader(reader&& other) noexcept :
+				m_Set{ std::exchange(other.m_Set, nullptr) },
+				m_Slot{ other.m_Slot }
+			{
+				ASSERT(other.m_Depth == 0, "Reader moved while reading!");
+			}
+			reader& operator=(reader&&) = delete;
+
+		public:
+			//Pins the set until the guard is destroyed, guards of one reader can nest
+			[[nodiscard]] read_guard pin() noexcept { return read_guard{ *this }; }
+
+			//Single lookups that pin the set for their own duration
+			[[nodiscard]] bool contains(KeyType key) noexcept { return pin().contains(key); }
+
+			//Copy of the value, nullopt when the key is not in the set
+			[[nodiscard]] std::optional<Val> get(KeyType key)
+			{
+				read_guard const guard{ pin() };
+				Val const* value{ guard.find(key) };
+				return value ? std::optional<Val>{ *value } : std::nullopt;
+			}
+
+		private:
+			friend class concurrent_sparse_set;
+			friend class read_guard;
+
+			concurrent_sparse_set* m_Set;
+			size_t m_Slot;
+			uint32_t m_Depth{ 0 };
+
+			explicit reader(concurrent_sparse_set& set) :
+				m_Set{ &set },
+				m_Slot{ set.m_Epochs.acquire_slot() }
+			{ }
+
+			void enter() noexcept
+			{
+				if (m_Depth++ == 0)
+				{
+					m_Set->m_Epochs.enter(m_Slot);
+				}
+			}
+
+			void exit() noexcept
+			{
+				if (--m_Depth == 0)
+				{
+					m_Set->m_Epochs.exit(m_Slot);
+				}
+			}
+		};
+
+		//Keeps the set pinned, pointers and references it hands out stay valid until it is destroyed
+		class read_guard final
+		{
+		public:
+			~read_guard() noexcept
+			{
+				m_Reader->exit();
+			}
+
+			read_guard(const read_guard&) = delete;
+			read_guard& operator=(const read_guard&) = delete;
+
+		public:
+			[[nodiscard]] bool contains(KeyType key) const noexcept
+			{
+				return find(key) != nullptr;
+			}
+
+			//nullptr when the key is not in the set
+			[[nodiscard]] Val const* find(KeyType key) const noexcept
+			{
+				version const& current{ m_Reader->m_Set->published() };
+				if (key >= current.sparseCapacity)
+				{
+					return nullptr;
+				}
+
+				KeyType const slot{ current.sparse[key].load(std::memory_order_acquire) };
+				return slot != INVALID_KEY ? current.values + slot : nullptr;
+			}
+
+			//Element must exist to get a valid value
+			Val const& operator[](KeyType key) const noexcept
+			{
+				Val const* value{ find(key) };
+				ASSERT(value, "Element not in set!");
+				return *value;
+			}
+
+			//Random access with bounds checking (similar to std::vector:::at())
+			Val const& at(KeyType key) const
+			{
+				if (Val const* value{ find(key) })
+				{
+					return *value;
+				}
+				throw sparse_set_out_of_range("Element not found in concurrent_sparse_set", key);
+			}
+
+			[[nodiscard]] size_t size() const noexcept { return m_Reader->m_Set->m_Count.load(std::memory_order_acquire); }
+			[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+			//Calls func(key, Val const&) for every element of the version that was published when the call started
+			template<typename Func>
+			requires std::is_invocable_v<Func&, KeyType, Val const&>
+			void each(Func&& func) const
+			{
+				version const& current{ m_Reader->m_Set->published() };
+				size_t const size{ current.size.load(std::memory_order_acquire) };
+				for (size_t slot{ 0 }; slot < size; ++slot)
+				{
+					KeyType const key{ current.dense[slot].load(std::memory_order_acquire) };
+					if (key != INVALID_KEY)
+					{
+						std::invoke(func, key, current.values[slot]);
+					}
+				}
+			}
+
+		private:
+			friend class reader;
+
+			reader* m_Reader;
+
+			explicit read_guard(reader& owner) noexcept :
+				m_Reader{ &owner }
+			{
+				m_Reader->enter();
+			}
+		};
+
+		//Throws std::length_error when maxReaders readers are already registered
+		[[nodiscard]] reader make_reader() { return reader{ *this }; }
+
+	public:
+		//Writer side, only one thread at a time may call the members below
+
+		[[nodiscard]] bool contains(KeyType key) const noexcept
+		{
+			version const& current{ writable() };
+			return key < current.sparseCapacity && current.sparse[key].load(std::memory_order_relaxed) != INVALID_KEY;
+		}
+
+		//Element must exist to get a valid value, use patch or assign to change it
+		Val const& operator[](KeyType key) const noexcept
+		{
+			ASSERT(contains(key), "Element not in set!");
+			version const& current{ writable() };
+			return current.values[current.sparse[key].load(std::memory_order_relaxed)];
+		}
+
+		[[nodiscard]] size_t size() const noexcept { return m_Count.load(std::memory_order_relaxed); }
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		//Slots of the current version, including the ones still held back for readers
+		[[nodiscard]] size_t capacity() const noexcept { return writable().capacity; }
+		[[nodiscard]] size_t sparse_capacity() const noexcept { return writable().sparseCapacity; }
+
+		//Element must not be in the set yet
+		template<typename... Args>
+		requires std::is_constructible_v<Val, Args&&...>
+		Val const& emplace(KeyType key, Args&&... args) noexcept
+		{
+			ASSERT(key != INVALID_KEY, "Element must be a valid index!");
+			ASSERT(!contains(key), "Element already in set!");
+
+			if (key >= writable().sparseCapacity)
+			{
+				size_t const sparseCapacity{ writable().sparseCapacity };
+				rebuild(std::max(static_cast<size_t>(key) + 1, sparseCapacity + sparseCapacity / 2), writable().capacity);
+			}
+
+			size_t const slot{ acquire_slot() };
+			version& current{ writable() };
+			Val const& value{ *std::construct_at(current.values + slot, std::forward<Args>(args)...) };
+
+			publish(current, key, slot);
+			m_Count.fetch_add(1, std::memory_order_release);
+			return value;
+		}
+
+		//Replaces the value of an existing element, readers see either the old or the new value
+		template<typename... Args>
+		requires std::is_constructible_v<Val, Args&&...>
+		Val const& assign(KeyType key, Args&&... args) noexcept
+		{
+			ASSERT(contains(key), "Element not in set!");
+
+			size_t const slot{ acquire_slot() };
+			version& current{ writable() };
+			size_t const old{ current.sparse[key].load(std::memory_order_relaxed) };
+
+			Val const& value{ *std::construct_at(current.values + slot, std::forward<Args>(args)...) };
+
+			publish(current, key, slot);
+			retire_slot(current, old);
+			return value;
+		}
+
+		//Calls func(Val&) on a copy of the value and publishes the copy, readers see either the old or the new value
+		template<typename Func>
+		requires std::is_invocable_v<Func&, Val&>
+		Val const& patch(KeyType key, Func&& func) noexcept
+		{
+			ASSERT(contains(key), "Element not in set!");
+
+			size_t const slot{ acquire_slot() };
+			version& current{ writable() };
+			size_t const old{ current.sparse[key].load(std::memory_order_relaxed) };
+
+			Val& value{ *std::construct_at(current.values + slot, std::as_const(current.values[old])) };
+			std::invoke(func, value);
+
+			publish(current, key, slot);
+			retire_slot(current, old);
+			return value;
+		}
+
+		//Do not erase an element that does not exist, use remove instead if this is a concern.
+		void erase(KeyType key) noexcept
+		{
+			ASSERT(contains(key), "Element not in set!");
+
+			version& current{ writable() };
+			size_t const slot{ current.sparse[key].load(std::memory_order_relaxed) };
+			current.sparse[key].store(INVALID_KEY, std::memory_order_release);
+			m_Count.fetch_sub(1, std::memory_order_release);
+
+			retire_slot(current, slot);
+		}
+
+		bool remove(KeyType key) noexcept
+		{
+			if (!contains(key))
+			{
+				return false;
+			}
+
+			erase(key);
+			return true;
+		}
+
+		//Publishes an empty version with the same capacities
+		void clear() noexcept
+		{
+			replace_version(std::make_unique<version>(writable().sparseCapacity, writable().capacity));
+			m_Count.store(0, std::memory_order_release);
+		}
+
+		void reserve(size_t newCap) noexcept
+		{
+			if (newCap > writable().capacity)
+			{
+				rebuild(writable().sparseCapacity, newCap);
+			}
+		}
+
+		void sparse_reserve(size_t newCap) noexcept
+		{
+			if (newCap > writable().sparseCapacity)
+			{
+				rebuild(newCap, writable().capacity);
+			}
+		}
+
+		//Publishes a copy without holes, the old version is freed once the readers left it
+		void compact() noexcept
+		{
+			rebuild(writable().sparseCapacity, std::max(size(), MIN_CAPACITY));
+		}
+
+		//Frees the versions and slots no reader can reach anymore. Writes call it on their own every RECLAIM_INTERVAL retirements
+		//and whenever the slots run out, call it to release memory sooner after a burst of writes.
+		void reclaim() noexcept
+		{
+			m_SinceReclaim = 0;
+			uint64_t const safe{ m_Epochs.safe_epoch() };
+
+			std::erase_if(m_RetiredVersions, [safe](const retired_version& retired) { return retired.epoch < safe; });
+
+			version& current{ writable() };
+			while (!m_RetiredSlots.empty() && m_RetiredSlots.front().epoch < safe)
+			{
+				size_t const slot{ m_RetiredSlots.front().slot };
+				m_RetiredSlots.pop_front();
+
+				std::destroy_at(current.values + slot);
+				current.states[slot] = slot_state::free;
+				m_FreeSlots.push_back(slot);
+			}
+		}
+
+	private:
+		static constexpr KeyType INVALID_KEY{ version::INVALID };
+		static constexpr size_t MIN_CAPACITY{ 16 };
+		static constexpr size_t RECLAIM_INTERVAL{ 64 };
+
+		struct retired_slot final
+		{
+			size_t slot;
+			uint64_t epoch;
+		};
+
+		struct retired_version final
+		{
+			std::unique_ptr<version> data;
+			uint64_t epoch;
+		};
+
+		Impl::epoch_domain m_Epochs;
+		std::atomic<version*> m_Version;
+		std::atomic<size_t> m_Count{ 0 };
+
+		//Writer only
+		std::deque<retired_slot> m_RetiredSlots{ };
+		std::vector<retired_version> m_RetiredVersions{ };
+		std::vector<size_t> m_FreeSlots{ };
+		size_t m_SinceReclaim{ 0 };
+
+		[[nodiscard]] version const& published() const noexcept { return *m_Version.load(std::memory_order_acquire); }
+		[[nodiscard]] version& writable() const noexcept { return *m_Version.load(std::memory_order_relaxed); }
+
+		//Reused slot if there is one, otherwise the next unused slot, grows once neither is left
+		[[nodiscard]] size_t acquire_slot() noexcept
+		{
+			if (m_FreeSlots.empty() && writable().size.load(std::memory_order_relaxed) == writable().capacity)
+			{
+				reclaim();
+			}
+
+			if (!m_FreeSlots.empty())
+			{
+				size_t const slot{ m_FreeSlots.back() };
+				m_FreeSlots.pop_back();
+				return slot;
+			}
+
+			if (writable().size.load(std::memory_order_relaxed) == writable().capacity)
+			{
+				rebuild(writable().sparseCapacity, std::max(MIN_CAPACITY, (size() + 1) * 2));
+			}
+
+			version& current{ writable() };
+			size_t const slot{ current.size.load(std::memory_order_relaxed) };
+			ASSERT(slot < INVALID_KEY, "Too many elements for the key type!");
+
+			//The slot is still invalid in the dense array, so iterating readers skip it until it is published
+			current.size.store(slot + 1, std::memory_order_release);
+			return slot;
+		}
+
+		//The value must be constructed, readers that see the key also see the value
+		void publish(version& current, KeyType key, size_t slot) noexcept
+		{
+			current.states[slot] = slot_state::live;
+			current.dense[slot].store(key, std::memory_order_release);
+			current.sparse[key].store(static_cast<KeyType>(slot), std::memory_order_release);
+		}
+
+		//The slot must be unreachable through the sparse array already
+		void retire_slot(version& current, size_t slot) noexcept
+		{
+			current.dense[slot].store(INVALID_KEY, std::memory_order_release);
+			current.states[slot] = slot_state::retired;
+			m_RetiredSlots.push_back({ slot, m_Epochs.retire() });
+
+			if (++m_SinceReclaim >= RECLAIM_INTERVAL)
+			{
+				reclaim();
+			}
+		}
+
+		//Copies the live elements into a new version without holes and publishes it
+		void rebuild(size_t sparseCapacity, size_t capacity) noexcept
+		{
+			version const& current{ writable() };
+			ASSERT(capacity >= size() && capacity <= INVALID_KEY, "Invalid capacity!");
+
+			auto next{ std::make_unique<version>(sparseCapacity, capacity) };
+			size_t count{ 0 };
+			for (size_t slot{ 0 }; slot < current.size.load(std::memory_order_relaxed); ++slot)
+			{
+				if (current.states[slot] != slot_state::live)
+				{
+					continue;
+				}
+
+				KeyType const key{ current.dense[slot].load(std::memory_order_relaxed) };
+				std::construct_at(next->values + count, current.values[slot]);
+				next->states[count] = slot_state::live;
+				next->dense[count].store(key, std::memory_order_relaxed);
+				next->sparse[key].store(static_cast<KeyType>(count), std::memory_order_relaxed);
+				++count;
+			}
+			next->size.store(count, std::memory_order_relaxed);
+
+			replace_version(std::move(next));
+		}
+
+		//The slots of the old version go with it
+		void replace_version(std::unique_ptr<version> next) noexcept
+		{
+			version* const old{ m_Version.exchange(next.release(), std::memory_order_acq_rel) };
+			m_RetiredVersions.push_back({ std::unique_ptr<version>{ old }, m_Epochs.retire() });
+			m_RetiredSlots.clear();
+			m_FreeSlots.clear();
+
+			if (++m_SinceReclaim >= RECLAIM_INTERVAL)
+			{
+				reclaim();
+			}
+		}
+	};
+}
+
+#endif
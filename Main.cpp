@@ -4,8 +4,21 @@
 #include <chrono>
 
 #include <random>
+#include <thread>
+#include <memory_resource>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
 
 #include "SparseSet.h"
+#include "SparseSetView.h"
+#include "SparseSetGroup.h"
+#include "SparseSoaSet.h"
+#include "StableSparseSet.h"
+#include "MappedSparseSet.h"
+#include "ConcurrentSparseSet.h"
+#include "ShardedSparseSet.h"
+#include "CommandBuffer.h"
 
 void TestSparseSetInit();
 void TestSparseSetEmplace();
@@ -17,6 +30,34 @@ void TestComplexTypes();
 
 void TestSorting();
 
+void TestPagedSparseSet();
+void TestBulkInsert();
+void TestBatchedErase();
+void TestBatchedLookup();
+
+void TestViews();
+void TestGroups();
+
+void TestRadixSort();
+void TestSortedMergeInsert();
+void BenchmarkParallelSort();
+void TestParallelEach();
+void TestSoaSet();
+void TestAllocators();
+void TestItems();
+void TestStableSparseSet();
+void TestDenseIndex();
+void TestHashedSparseSet();
+void TestPresenceBitset();
+void TestChangeTracking();
+void TestSnapshot();
+void TestSparseTrim();
+void TestConcurrentSparseSet();
+void BenchmarkConcurrentReads();
+void TestShardedSparseSet();
+void TestCommandBuffer();
+void TestStats();
+
 int RandomInt(int min, int max) 
 {
     static std::random_device rd;
@@ -40,6 +81,34 @@ int main()
 
     TestSorting();
 
+    TestPagedSparseSet();
+    TestBulkInsert();
+    TestBatchedErase();
+    TestBatchedLookup();
+
+    TestViews();
+    TestGroups();
+
+    TestRadixSort();
+    TestSortedMergeInsert();
+    BenchmarkParallelSort();
+    TestParallelEach();
+    TestSoaSet();
+    TestAllocators();
+    TestItems();
+    TestStableSparseSet();
+    TestDenseIndex();
+    TestHashedSparseSet();
+    TestPresenceBitset();
+    TestChangeTracking();
+    TestSnapshot();
+    TestSparseTrim();
+    TestConcurrentSparseSet();
+    BenchmarkConcurrentReads();
+    TestShardedSparseSet();
+    TestCommandBuffer();
+    TestStats();
+
     return 0;
 }
 
@@ -403,10 +472,12 @@ void TestSorting()
         {
             std::sort(durations.begin(), durations.end());
 
-            const int discardCount { static_cast<int>(durations.size() * 0.1f)};
+            //Trimmed mean, the fastest and slowest 10% are dropped from the sum and the count
+            const auto discardCount{ static_cast<std::ptrdiff_t>(durations.size() / 10) };
+            const auto keptCount{ static_cast<long long>(durations.size()) - 2 * discardCount };
             const auto sum{ std::accumulate(durations.begin() + discardCount, durations.end() - discardCount, 0LL) };
 
-            return sum / durations.size();
+            return sum / std::max(keptCount, 1LL);
         };
 
     const auto avgDuration1{ calc_avg(durations1) };
@@ -439,4 +510,1017 @@ void TestSorting()
         std::cout << emplSet.sparse_index(it) << "\n";
     }
     std::cout << "\n\n";
-}
\ No newline at end of file
+}
+
+void TestPagedSparseSet()
+{
+    std::cout << "\nPAGED SPARSE SET\n";
+
+    Internal::sparse_set<int, uint32_t, Internal::paged_sparse<>> set{ };
+    set.emplace(4'000'000'000u, 40);
+    set.emplace(7, 70);
+    set.emplace(4'000'000'001u, 41);
+
+    std::cout << "Sparse Size: " << set.sparse_size() << ", pages: " << set.get_sparse_storage().page_count()
+              << ", sparse bytes: " << set.get_sparse_storage().memory_usage() << "\n";
+    std::cout << std::boolalpha << set.contains(4'000'000'000u) << "\n";
+    std::cout << std::boolalpha << set.contains(8) << "\n";
+    std::cout << set[7] << "\n";
+    std::cout << *set.find(4'000'000'001u) << "\n";
+
+    set.erase(4'000'000'000u);
+    set.erase(4'000'000'001u);
+    std::cout << std::boolalpha << set.contains(4'000'000'000u) << "\n";
+
+    for (auto it{ set.begin() }; auto && e : set)
+    {
+        std::cout << e << ", " << set.sparse_index(it) << "\n";
+        ++it;
+    }
+}
+
+void TestBulkInsert()
+{
+    std::cout << "\nBULK INSERT\n";
+
+    std::vector<uint32_t> keys{ 5, 1, 9, 3 };
+    std::vector<int> values{ 50, 10, 90, 30 };
+
+    Internal::sparse_set<int> set{ };
+    set.emplace_bulk(keys, values);
+
+    for (auto it{ set.begin() }; auto && e : set)
+    {
+        std::cout << e << ", " << set.sparse_index(it) << "\n";
+        ++it;
+    }
+    std::cout << "Sparse Size: " << set.sparse_size() << "\n";
+
+    std::vector<uint32_t> moreKeys{ 9, 2, 2, 12 };
+    std::vector<int> moreValues{ 900, 20, 200, 120 };
+    std::cout << set.try_emplace_bulk(moreKeys, moreValues) << "\n";
+    std::cout << set[9] << ", " << set[2] << ", " << set[12] << "\n";
+
+    std::vector<uint32_t> const copyKeys{ 20, 21 };
+    std::vector<int> const copyValues{ 200, 210 };
+    set.insert_range(copyKeys, copyValues);
+    std::cout << set.size() << ", " << set[21] << "\n";
+}
+
+void TestBatchedErase()
+{
+    std::cout << "\nBATCHED ERASE\n";
+
+    Internal::sparse_set<int> set{ };
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        set.emplace(i, static_cast<int>(i) * 10);
+    }
+
+    std::vector<uint32_t> const keys{ 1, 8, 3, 3, 42 };
+    std::cout << set.erase_many(keys) << "\n";
+
+    for (auto it{ set.begin() }; auto && e : set)
+    {
+        std::cout << e << ", " << set.sparse_index(it) << "\n";
+        ++it;
+    }
+    std::cout << "\n";
+
+    std::cout << set.erase_if([](int val) { return val >= 60; }) << "\n";
+    std::cout << set.erase_if([](uint32_t key, int) { return key == 0; }) << "\n";
+
+    for (auto it{ set.begin() }; auto && e : set)
+    {
+        std::cout << e << ", " << set.sparse_index(it) << "\n";
+        ++it;
+    }
+}
+
+void TestBatchedLookup()
+{
+    std::cout << "\nBATCHED LOOKUP\n";
+
+    Internal::sparse_set<int> set{ };
+    for (uint32_t i = 0; i < 100; i += 3)
+    {
+        set.emplace(i, static_cast<int>(i) * 10);
+    }
+
+    std::vector<uint32_t> keys{};
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        keys.emplace_back(i);
+    }
+    keys.emplace_back(1'000'000);
+
+    std::vector<uint64_t> mask((keys.size() + 63) / 64);
+    std::cout << set.contains_many(keys, mask) << "\n";
+    std::cout << std::hex << mask[0] << std::dec << "\n";
+
+    std::vector<int*> values(keys.size());
+    std::cout << set.get_many(keys, std::span<int*>{ values }) << "\n";
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        if (values[i])
+        {
+            std::cout << keys[i] << ", " << *values[i] << "\n";
+        }
+    }
+}
+
+void TestViews()
+{
+    std::cout << "\nVIEWS\n";
+
+    Internal::sparse_set<int> positions{ };
+    Internal::sparse_set<std::string> names{ };
+    struct Disabled final { };
+    Internal::sparse_set<Disabled> disabled{ };
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        positions.emplace(i, static_cast<int>(i) * 10);
+    }
+    names.emplace(2, "two");
+    names.emplace(5, "five");
+    names.emplace(7, "seven");
+    names.emplace(42, "forty two");
+    disabled.emplace(5);
+
+    for (auto [key, position, name] : Internal::view(positions, names).exclude(disabled))
+    {
+        std::cout << key << ", " << position << ", " << name << "\n";
+    }
+    std::cout << "\n";
+
+    Internal::view(positions, names).each([](uint32_t key, int& position, std::string const& name)
+        {
+            position += 1;
+            std::cout << key << ", " << position << ", " << name << "\n";
+        });
+}
+
+void TestGroups()
+{
+    std::cout << "\nGROUPS\n";
+
+    Internal::sparse_set<int> positions{ };
+    Internal::sparse_set<float> velocities{ };
+
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        positions.emplace(i, static_cast<int>(i) * 10);
+    }
+    velocities.emplace(4, 4.f);
+    velocities.emplace(1, 1.f);
+
+    Internal::owning_group group{ positions, velocities };
+    velocities.emplace(3, 3.f);
+    velocities.emplace(9, 9.f);
+    positions.erase(1);
+
+    std::cout << "Group size: " << group.size() << "\n";
+    for (auto [key, position, velocity] : group)
+    {
+        std::cout << key << ", " << position << ", " << velocity << "\n";
+    }
+    std::cout << "\n";
+
+    group.each([](uint32_t key, int& position, float& velocity)
+        {
+            position += static_cast<int>(velocity);
+            std::cout << key << ", " << position << "\n";
+        });
+
+    //Copies of an owned set are plain sets, the group keeps owning the original only
+    Internal::sparse_set<int> positionsCopy{ positions };
+    Internal::sparse_set<int> positionsAssigned{ };
+    positionsAssigned = positions;
+    std::cout << "copies unowned: " << std::boolalpha << (positions.owned() && !positionsCopy.owned() && !positionsAssigned.owned()) << "\n";
+}
+
+void TestRadixSort()
+{
+    std::cout << "\nRADIX SORT\n";
+
+    struct Sprite final
+    {
+        int depth;
+        std::string name = " ";
+    };
+
+    Internal::sparse_set<Sprite> sprites{ };
+    sprites.emplace(7, -3, "seven");
+    sprites.emplace(2, 10, "two");
+    sprites.emplace(5, 0, "five");
+    sprites.emplace(1, -8, "one");
+
+    sprites.sort_by([](Sprite const& sprite) { return sprite.depth; });
+    for (auto [key, e] : sprites.items())
+    {
+        std::cout << e.depth << ", " << e.name << ", " << key << "\n";
+    }
+    std::cout << "\n";
+
+    sprites.sort_by_key();
+    for (auto [key, e] : sprites.items())
+    {
+        std::cout << e.depth << ", " << e.name << ", " << key << "\n";
+    }
+}
+
+void BenchmarkParallelSort()
+{
+    std::cout << "\nPARALLEL SORT BENCHMARK\n";
+
+    constexpr int NUM_ELEMENTS{ 1'000'000 };
+    constexpr int NUM_TRIALS{ 5 };
+
+    Internal::sparse_set<int> source{ };
+    source.reserve(NUM_ELEMENTS);
+    for (int i = 0; i < NUM_ELEMENTS; ++i)
+    {
+        source.emplace(static_cast<uint32_t>(i), RandomInt(0, 1'000'000'000));
+    }
+
+    auto const compare{ [](const auto& a, const auto& b) { return a < b; } };
+
+    size_t const maxThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+    long long baseline{ 0 };
+
+    std::vector<size_t> threadCounts{};
+    for (size_t threads{ 1 }; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.emplace_back(threads);
+    }
+    threadCounts.emplace_back(maxThreads);
+
+    for (size_t const threads : threadCounts)
+    {
+        std::vector<long long> durations{};
+
+        //The calling thread takes part in the sort, so the pool gets one thread less
+        std::unique_ptr<Internal::thread_pool> pool{ threads > 1 ? std::make_unique<Internal::thread_pool>(threads - 1) : nullptr };
+
+        for (int trial{ 0 }; trial < NUM_TRIALS; ++trial)
+        {
+            auto set{ source };
+
+            auto start = std::chrono::high_resolution_clock::now();
+            if (pool)
+            {
+                set.parallel_sort(*pool, compare);
+            }
+            else
+            {
+                set.sort(compare);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+
+            durations.emplace_back(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+        }
+
+        std::sort(durations.begin(), durations.end());
+        long long const median{ durations[durations.size() / 2] };
+        if (threads == 1)
+        {
+            baseline = median;
+        }
+
+        std::cout << threads << " threads: " << median << " microseconds, speedup " 
+                  << static_cast<double>(baseline) / static_cast<double>(std::max(median, 1LL)) << "\n";
+    }
+}
+void TestParallelEach()
+{
+    std::cout << "\nPARALLEL EACH\n";
+
+    constexpr uint32_t NUM_ELEMENTS{ 100'000 };
+
+    Internal::sparse_set<float> velocities{ };
+    velocities.reserve(NUM_ELEMENTS);
+    for (uint32_t i = 0; i < NUM_ELEMENTS; ++i)
+    {
+        velocities.emplace(i, 0.1f);
+    }
+
+    velocities.parallel_for_each([](float& velocity) { velocity *= 2.f; });
+    velocities.parallel_each([](uint32_t key, float& velocity) { velocity += static_cast<float>(key % 10); });
+
+    std::cout << velocities[0] << ", " << velocities[7] << ", " << velocities[NUM_ELEMENTS - 1] << "\n";
+
+    Internal::thread_pool pool{ 2 };
+    auto const sum = [&](auto& executor)
+        {
+            return velocities.parallel_reduce(executor, 0.0, [](float velocity) { return static_cast<double>(velocity); }, std::plus<>{ });
+        };
+
+    double const poolSum{ sum(pool) };
+    double const defaultSum{ velocities.parallel_reduce(0.0, [](uint32_t, float velocity) { return static_cast<double>(velocity); }, std::plus<>{ }) };
+    std::cout << poolSum << ", same result: " << (poolSum == defaultSum ? "true" : "false") << "\n";
+}
+
+void TestSortedMergeInsert()
+{
+    std::cout << "\nSORTED MERGE INSERT\n";
+
+    Internal::sparse_set<int> drawOrder{ };
+    drawOrder.emplace(3, 20);
+    drawOrder.emplace(8, 5);
+    drawOrder.emplace(1, 40);
+    drawOrder.sort();
+
+    std::vector<uint32_t> keys{ 4, 9, 2, 6 };
+    std::vector<int> depths{ 30, 0, 20, 50 };
+    drawOrder.insert_sorted_range(keys, depths);
+
+    for (auto [key, e] : drawOrder.items())
+    {
+        std::cout << e << ", " << key << "\n";
+    }
+    std::cout << "sorted: " << (drawOrder.is_sorted() ? "true" : "false") << "\n";
+}
+
+void TestSoaSet()
+{
+    std::cout << "\nSOA SET\n";
+
+    Internal::sparse_soa_set<float, float, std::string> particles{ };
+    particles.emplace(4, 1.f, 0.5f, "four");
+    particles.emplace(1, 3.f, -1.f, "one");
+    particles.emplace(9, 2.f, 2.f, "nine");
+    particles.emplace(6, 0.f, 1.f, "six");
+
+    //Per field kernel over two contiguous columns
+    auto positions{ particles.column<0>() };
+    auto const velocities{ particles.column<1>() };
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        positions[i] += velocities[i];
+    }
+
+    particles.erase(1);
+    particles.sort<0>();
+
+    for (auto&& [key, position, velocity, name] : particles)
+    {
+        std::cout << key << ", " << position << ", " << velocity << ", " << name << "\n";
+    }
+    std::cout << "\n";
+
+    particles.sort_by_key();
+    particles.each([](uint32_t key, float position, float, std::string const& name)
+        {
+            std::cout << key << ", " << position << ", " << name << "\n";
+        });
+}
+
+void TestAllocators()
+{
+    std::cout << "\nALLOCATORS\n";
+
+    //Frame arena, the null upstream resource makes sure nothing falls back to the global heap
+    std::array<std::byte, 64 * 1024> buffer{ };
+    std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size(), std::pmr::null_memory_resource() };
+
+    Internal::pmr::sparse_set<int> depths{ &arena };
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        depths.emplace(i * 3, RandomInt(0, 1000));
+    }
+    depths.sort();
+
+    Internal::pmr::sparse_set<int> copy{ depths };
+    std::cout << "copy uses the default resource: " << (copy.get_allocator().resource() == std::pmr::get_default_resource() ? "true" : "false") << "\n";
+
+    //Swapping sets on different resources swaps the elements, every set keeps its own resource
+    copy.erase(0);
+    copy.swap(depths);
+    std::cout << depths.size() << ", " << copy.size() << ", " << (depths.get_allocator().resource() == &arena ? "true" : "false") << "\n";
+
+    //Separate resources for the sparse, dense and packed arrays
+    std::pmr::unsynchronized_pool_resource pool{ };
+    Internal::pmr::sparse_set<float, uint32_t, Internal::paged_sparse<256>> velocities{ &pool, &arena, &arena };
+    velocities.emplace(5000, 1.f);
+    velocities.emplace(12, 2.f);
+    std::cout << velocities[5000] << ", " << velocities[12] << ", sorted: " << (copy.is_sorted() ? "true" : "false") << "\n";
+}
+
+void TestItems()
+{
+    std::cout << "\nITEMS\n";
+
+    Internal::sparse_set<int> set{ };
+    set.emplace(7, 70);
+    set.emplace(2, 20);
+    set.emplace(5, 50);
+
+    static_assert(std::ranges::random_access_range<decltype(set.items())>);
+    static_assert(std::ranges::sized_range<decltype(std::as_const(set).items())>);
+
+    for (auto [key, value] : set.items())
+    {
+        value += static_cast<int>(key);
+    }
+
+    for (auto [key, value] : set.items() | std::views::reverse)
+    {
+        std::cout << key << ", " << value << "\n";
+    }
+    std::cout << "\n";
+
+    auto const items{ std::as_const(set).items() };
+    auto const largest{ std::ranges::max_element(items, { }, [](auto const& item) { return item.second; }) };
+    std::cout << "largest: " << (*largest).first << ", " << items[1].second << "\n";
+
+    int sum{ 0 };
+    set.each([&sum](uint32_t key, int& value) { sum += value - static_cast<int>(key); });
+    std::cout << "sum: " << sum << "\n";
+}
+
+void TestStableSparseSet()
+{
+    std::cout << "\nSTABLE SPARSE SET\n";
+
+    Internal::stable_sparse_set<std::string> names{ };
+    names.emplace(10, "ten");
+    names.emplace(20, "twenty");
+    names.emplace(30, "thirty");
+    names.emplace(40, "forty");
+
+    //Dense indices of the other elements survive the erase
+    size_t const thirty{ names.index(30) };
+    names.erase(20);
+    names.erase(10);
+    std::cout << (names.index(30) == thirty ? "stable" : "moved") << ", tombstones: " << names.tombstone_count() << "\n";
+
+    //Reuses the slot of 10
+    names.emplace(50, "fifty");
+    std::cout << "50 at " << names.index(50) << "\n";
+
+    for (auto [key, name] : names.items())
+    {
+        std::cout << key << ", " << name << "\n";
+    }
+    std::cout << "\n";
+
+    names.compact([](uint32_t key, size_t from, size_t to) { std::cout << key << ": " << from << " -> " << to << "\n"; });
+    names.each([](uint32_t key, std::string const& name) { std::cout << key << ", " << name << "\n"; });
+}
+
+void TestDenseIndex()
+{
+    std::cout << "\nDENSE INDEX\n";
+
+    //64 bit keys, at most a few thousand elements so the sparse storage only needs 16 bit indices
+    using small_set = Internal::sparse_set<int, uint64_t, Internal::paged_sparse<1024>, std::allocator<int>, Internal::dense_index_t<4096>>;
+    small_set set{ };
+
+    std::cout << "index bytes: " << sizeof(small_set::dense_type) << ", max size: " << small_set::max_size() << "\n";
+
+    for (uint64_t i = 0; i < 4096; ++i)
+    {
+        set.emplace(i * 1'009, static_cast<int>(i));
+    }
+    set.erase(0);
+    set.erase(uint64_t{ 4095 } * 1'009);
+
+    bool valid{ set.size() == 4094 };
+    for (auto [key, value] : set.items())
+    {
+        valid &= set[key] == value && key == static_cast<uint64_t>(value) * 1'009;
+    }
+    std::cout << (valid ? "valid" : "invalid") << ", last index: " << set.index(set.dense().back()) << "\n";
+}
+
+void TestHashedSparseSet()
+{
+    std::cout << "\nHASHED SPARSE SET\n";
+
+    //Hashed 64 bit ids, a flat or paged array would never fit
+    Internal::sparse_set<int, uint64_t, Internal::hashed_sparse> ids{ };
+    ids.emplace(0x9E3779B97F4A7C15ull, 1);
+    ids.emplace(0xFFFF'0000'0000'0001ull, 2);
+    ids.emplace(42, 3);
+    ids.erase(0x9E3779B97F4A7C15ull);
+
+    std::cout << std::boolalpha << ids.contains(0xFFFF'0000'0000'0001ull) << ", " << ids.contains(0x9E3779B97F4A7C15ull) << "\n";
+    for (auto [key, value] : ids.items())
+    {
+        std::cout << key << ", " << value << "\n";
+    }
+
+    //Dense entity ids stay in the flat array, a few scattered external ids switch the set to the hash table
+    Internal::sparse_set<int, uint64_t, Internal::adaptive_sparse<>> mixed{ };
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        mixed.emplace(i, static_cast<int>(i));
+    }
+    std::cout << "hashed: " << mixed.get_sparse_storage().is_hashed() << "\n";
+
+    mixed.emplace(1ull << 40, -1);
+    std::cout << "hashed: " << mixed.get_sparse_storage().is_hashed() << ", " << mixed[1ull << 40] << ", " << mixed[999] << "\n";
+
+    mixed.erase(1ull << 40);
+    mixed.shrink_to_fit();
+    std::cout << "hashed: " << mixed.get_sparse_storage().is_hashed() << ", size: " << mixed.size() << "\n";
+}
+
+void TestPresenceBitset()
+{
+    std::cout << "\nPRESENCE BITSET\n";
+
+    Internal::sparse_set<float, uint32_t, Internal::bitset_sparse<>> positions{ };
+    Internal::sparse_set<int, uint32_t, Internal::bitset_sparse<Internal::paged_sparse<>>> health{ };
+
+    for (uint32_t i = 0; i < 20; i += 2)
+    {
+        positions.emplace(i, static_cast<float>(i));
+    }
+    for (uint32_t i = 0; i < 20; i += 3)
+    {
+        health.emplace(i, 100);
+    }
+    health.emplace(1'000'000, 50);
+    positions.erase(6);
+
+    auto print = [](std::string_view name, auto const& keys)
+        {
+            std::cout << name << ":";
+            keys.each([](size_t key) { std::cout << " " << key; });
+            std::cout << "\n";
+        };
+
+    print("intersection", Internal::set_intersection(positions, health));
+    print("union", Internal::set_union(positions, health));
+    print("difference", Internal::set_difference(health, positions));
+
+    //Dense order is insertion order, key order comes from the bitset
+    positions.emplace(1, 1.0f);
+    positions.each_by_key([](uint32_t key, float value) { std::cout << key << " = " << value << ", "; });
+    std::cout << "\n";
+}
+
+void TestChangeTracking()
+{
+    std::cout << "\nCHANGE TRACKING\n";
+
+    Internal::tracked_sparse_set<int> scores{ };
+    scores.emplace(1, 10);
+    scores.emplace(2, 20);
+    scores.emplace(3, 30);
+    scores.clear_changes();
+
+    scores.patch(1) += 5;
+    scores.erase(2);
+    scores.emplace(4, 40);
+    scores.emplace(5, 50);
+    scores.erase(5);
+    scores[3] = 35;
+    scores.mark_dirty(3);
+
+    auto print = [](uint32_t key, Internal::change_kind kind)
+        {
+            constexpr std::string_view names[]{ "none", "added", "modified", "removed" };
+            std::cout << key << " " << names[static_cast<size_t>(kind)] << "\n";
+        };
+
+    bool reordered{ scores.consume_changes(print) };
+    std::cout << "reordered: " << std::boolalpha << reordered << "\n";
+
+    scores.sort();
+    reordered = scores.consume_changes(print);
+    std::cout << "reordered: " << std::boolalpha << reordered << "\n";
+
+    std::cout << "untracked size: " << sizeof(Internal::sparse_set<int>) << ", tracked size: " << sizeof(Internal::tracked_sparse_set<int>) << "\n";
+}
+
+void TestSnapshot()
+{
+    std::cout << "\nSNAPSHOT\n";
+
+    struct Position
+    {
+        float x, y;
+    };
+
+    Internal::sparse_set<Position> positions{ };
+    for (uint32_t i{ 0 }; i < 10; ++i)
+    {
+        positions.emplace(i * 3, static_cast<float>(i), static_cast<float>(i) * 0.5f);
+    }
+    positions.erase(6);
+
+    auto const path{ std::filesystem::temp_directory_path() / "sparse_set_snapshot.bin" };
+    positions.save(path);
+
+    Internal::sparse_set<Position, uint32_t, Internal::paged_sparse<>> loaded{ };
+    loaded.load(path);
+    std::cout << "loaded size: " << loaded.size() << ", 9 -> " << loaded[9].x << " " << loaded[9].y << "\n";
+
+    {
+        Internal::mapped_sparse_set<Position> mapped{ path };
+        std::cout << "mapped size: " << mapped.size() << ", contains 6: " << std::boolalpha << mapped.contains(6) << "\n";
+        for (auto [key, position] : mapped.items())
+        {
+            std::cout << key << " -> " << position.x << " " << position.y << "\n";
+        }
+    }
+
+    try
+    {
+        Internal::sparse_set<double> wrong{ };
+        wrong.load(path);
+    }
+    catch (const Internal::sparse_set_snapshot_error& error)
+    {
+        std::cout << "error: " << error.what() << "\n";
+    }
+
+    std::filesystem::remove(path);
+}
+
+void TestSparseTrim()
+{
+    std::cout << "\nSPARSE TRIM\n";
+
+    Internal::sparse_set<int> set{ };
+    set.emplace(3, 3);
+    set.emplace(100'000, 1);
+    set.erase(100'000);
+    std::cout << "before trim: " << set.sparse_size() << "\n";
+    set.trim_sparse();
+    std::cout << "after trim: " << set.sparse_size() << ", capacity: " << set.get_sparse_storage().capacity() << "\n";
+
+    //Trims itself once less than a quarter of the sparse capacity is in use
+    Internal::sparse_set<int, uint32_t, Internal::basic_flat_sparse<Internal::geometric_growth<3, 2, 25>>> autoTrim{ };
+    for (uint32_t i{ 0 }; i < 10; ++i)
+    {
+        autoTrim.emplace(i, static_cast<int>(i));
+    }
+    autoTrim.emplace(1'000'000, 0);
+    std::cout << "grown: " << autoTrim.sparse_size() << "\n";
+    autoTrim.erase(1'000'000);
+    std::cout << "auto trimmed: " << autoTrim.sparse_size() << ", capacity: " << autoTrim.get_sparse_storage().capacity() << "\n";
+
+    Internal::sparse_set<int, uint32_t, Internal::basic_flat_sparse<Internal::page_growth<1024>>> paged{ };
+    paged.emplace(1, 1);
+    std::cout << "page growth capacity: " << paged.get_sparse_storage().capacity() << "\n";
+}
+
+void TestConcurrentSparseSet()
+{
+    std::cout << "\nCONCURRENT SPARSE SET\n";
+
+    struct Entry
+    {
+        uint32_t key;
+        std::string name;
+        uint32_t revision;
+    };
+
+    constexpr uint32_t KEY_RANGE{ 4096 };
+    constexpr int NUM_WRITES{ 200'000 };
+
+    Internal::concurrent_sparse_set<Entry> set{ };
+    std::atomic<bool> done{ false };
+    std::atomic<size_t> errors{ 0 };
+    std::atomic<size_t> reads{ 0 };
+
+    //Readers check that every value they reach belongs to its key and was never partially written
+    size_t const readerCount{ std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8) - 1 };
+    std::vector<std::jthread> readers{};
+    for (size_t r{ 0 }; r < readerCount; ++r)
+    {
+        readers.emplace_back([&set, &done, &errors, &reads, seed{ static_cast<uint32_t>(r) }]()
+            {
+                auto reader{ set.make_reader() };
+                std::mt19937 gen{ seed };
+                size_t count{ 0 };
+
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    uint32_t const key{ static_cast<uint32_t>(gen() % KEY_RANGE) };
+                    auto const guard{ reader.pin() };
+
+                    Entry const* entry{ guard.find(key) };
+                    if (entry && (entry->key != key || entry->name != std::to_string(key)))
+                    {
+                        errors.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    if (key % 64 == 0)
+                    {
+                        guard.each([&errors](uint32_t k, Entry const& e)
+                            {
+                                if (e.key != k || e.name != std::to_string(k))
+                                {
+                                    errors.fetch_add(1, std::memory_order_relaxed);
+                                }
+                            });
+                    }
+                    ++count;
+                }
+
+                reads.fetch_add(count, std::memory_order_relaxed);
+            });
+    }
+
+    std::mt19937 gen{ 42 };
+    for (int i{ 0 }; i < NUM_WRITES; ++i)
+    {
+        uint32_t const key{ static_cast<uint32_t>(gen() % KEY_RANGE) };
+        if (!set.contains(key))
+        {
+            set.emplace(key, Entry{ key, std::to_string(key), 0 });
+            continue;
+        }
+
+        switch (gen() % 3)
+        {
+        case 0:
+            set.erase(key);
+            break;
+        case 1:
+            set.patch(key, [](Entry& e) { ++e.revision; });
+            break;
+        default:
+            set.assign(key, Entry{ key, std::to_string(key), set[key].revision + 10 });
+            break;
+        }
+    }
+
+    done = true;
+    readers.clear();
+
+    std::cout << "readers: " << readerCount << ", reads: " << reads.load() << ", errors: " << errors.load() << ", size: " << set.size() << "\n";
+}
+
+void BenchmarkConcurrentReads()
+{
+    std::cout << "\nCONCURRENT READ BENCHMARK\n";
+
+    constexpr uint32_t NUM_KEYS{ 100'000 };
+    constexpr auto DURATION{ std::chrono::milliseconds{ 200 } };
+
+    //One writer keeps erasing and emplacing while the readers look up random keys for DURATION, returns the lookups per second
+    auto const measure = [&](size_t readerCount, auto&& emplace, auto&& erase, auto&& makeLookup)
+        {
+            for (uint32_t key{ 0 }; key < NUM_KEYS; ++key)
+            {
+                emplace(key);
+            }
+
+            std::atomic<bool> done{ false };
+            std::atomic<size_t> reads{ 0 };
+            std::atomic<size_t> hits{ 0 };
+            std::vector<std::jthread> threads{};
+
+            for (size_t r{ 0 }; r < readerCount; ++r)
+            {
+                threads.emplace_back([&, seed{ static_cast<uint32_t>(r) }]()
+                    {
+                        auto lookup{ makeLookup() };
+                        std::mt19937 gen{ seed };
+                        size_t count{ 0 };
+                        size_t found{ 0 };
+
+                        while (!done.load(std::memory_order_relaxed))
+                        {
+                            found += lookup(static_cast<uint32_t>(gen() % NUM_KEYS)) ? 1 : 0;
+                            ++count;
+                        }
+
+                        reads.fetch_add(count, std::memory_order_relaxed);
+                        hits.fetch_add(found, std::memory_order_relaxed);
+                    });
+            }
+
+            threads.emplace_back([&]()
+                {
+                    std::mt19937 gen{ 7 };
+                    while (!done.load(std::memory_order_relaxed))
+                    {
+                        uint32_t const key{ static_cast<uint32_t>(gen() % NUM_KEYS) };
+                        erase(key);
+                        emplace(key);
+                    }
+                });
+
+            std::this_thread::sleep_for(DURATION);
+            done = true;
+            threads.clear();
+
+            return static_cast<double>(reads.load()) / std::chrono::duration<double>(DURATION).count();
+        };
+
+    size_t const maxReaders{ std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1 };
+    for (size_t readers{ 1 }; ; readers = std::min(readers * 2, maxReaders))
+    {
+        Internal::sparse_set<uint64_t> locked{ };
+        std::shared_mutex mutex{ };
+        double const lockedRate{ measure(readers,
+            [&](uint32_t key) { std::unique_lock const lock{ mutex }; locked.emplace(key, key); },
+            [&](uint32_t key) { std::unique_lock const lock{ mutex }; locked.erase(key); },
+            [&]() { return [&](uint32_t key) { std::shared_lock const lock{ mutex }; return locked.contains(key) && locked[key] == key; }; }) };
+
+        Internal::concurrent_sparse_set<uint64_t> concurrent{ };
+        double const concurrentRate{ measure(readers,
+            [&](uint32_t key) { concurrent.emplace(key, key); },
+            [&](uint32_t key) { concurrent.erase(key); },
+            [&]() { return [reader{ concurrent.make_reader() }](uint32_t key) mutable { auto const guard{ reader.pin() }; uint64_t const* value{ guard.find(key) }; return value && *value == key; }; }) };
+
+        std::cout << readers << " readers: shared_mutex " << lockedRate / 1e6 << " M lookups/s, concurrent " << concurrentRate / 1e6
+                  << " M lookups/s, speedup " << concurrentRate / std::max(lockedRate, 1.0) << "\n";
+
+        if (readers == maxReaders)
+        {
+            break;
+        }
+    }
+}
+
+void TestShardedSparseSet()
+{
+    std::cout << "\nSHARDED SPARSE SET\n";
+
+    constexpr uint32_t KEY_RANGE{ 200'000 };
+    constexpr int NUM_WRITES{ 100'000 };
+
+    //Every writer ingests its own stride of the key space and removes a part of it again, the strides hit every shard
+    size_t const writerCount{ std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8) };
+    auto const ingest = [&](auto&& tryEmplace, auto&& remove)
+        {
+            auto const start{ std::chrono::high_resolution_clock::now() };
+            std::vector<std::jthread> writers{};
+            for (size_t w{ 0 }; w < writerCount; ++w)
+            {
+                writers.emplace_back([&, w]()
+                    {
+                        std::mt19937 gen{ static_cast<uint32_t>(w) };
+                        for (int i{ 0 }; i < NUM_WRITES; ++i)
+                        {
+                            uint32_t const key{ static_cast<uint32_t>((gen() % (KEY_RANGE / writerCount)) * writerCount + w) };
+                            if (gen() % 4 != 0)
+                            {
+                                tryEmplace(key);
+                            }
+                            else
+                            {
+                                remove(key);
+                            }
+                        }
+                    });
+            }
+            writers.clear();
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+
+    Internal::sparse_set<uint64_t> locked{ };
+    std::mutex mutex{ };
+    double const lockedTime{ ingest(
+        [&](uint32_t key) { std::unique_lock const lock{ mutex }; if (!locked.contains(key)) { locked.emplace(key, key); } },
+        [&](uint32_t key) { std::unique_lock const lock{ mutex }; locked.remove(key); }) };
+
+    Internal::sharded_sparse_set<uint64_t> sharded{ };
+    double const shardedTime{ ingest(
+        [&](uint32_t key) { sharded.try_emplace(key, key); },
+        [&](uint32_t key) { sharded.remove(key); }) };
+
+    std::cout << writerCount << " writers: single mutex " << lockedTime << " ms, sharded " << shardedTime << " ms\n";
+
+    //Both ran the same operations per key, so they must end up with the same keys
+    size_t mismatches{ 0 };
+    for (auto [key, value] : sharded.items())
+    {
+        mismatches += (value != key || !locked.contains(key)) ? 1 : 0;
+    }
+    std::cout << "size: " << sharded.size() << ", expected: " << locked.size() << ", mismatches: " << mismatches << "\n";
+
+    sharded.parallel_each([](uint32_t key, uint64_t& value) { value = uint64_t{ key } * 2; });
+
+    uint64_t sum{ 0 };
+    uint64_t expected{ 0 };
+    sharded.each([&sum](uint32_t, uint64_t const& value) { sum += value; });
+    locked.each([&expected](uint32_t key, uint64_t const&) { expected += uint64_t{ key } * 2; });
+    std::cout << "sum after parallel_each: " << sum << ", expected: " << expected << ", at(" << locked.dense()[0] << "): " << sharded.at(locked.dense()[0]) << "\n";
+}
+
+void TestCommandBuffer()
+{
+    std::cout << "\nCOMMAND BUFFER\n";
+
+    constexpr uint32_t NUM_KEYS{ 10'000 };
+    constexpr size_t NUM_JOBS{ 8 };
+
+    Internal::sparse_set<std::string> set{ };
+    for (uint32_t key{ 0 }; key < NUM_KEYS; ++key)
+    {
+        set.emplace(key, std::to_string(key));
+    }
+
+    //Jobs iterate the set in parallel and only record their changes, the set is untouched until the flush
+    Internal::command_queue<std::string> commands{ NUM_JOBS };
+    Internal::Impl::run_chunks(Internal::default_thread_pool(), NUM_JOBS, [&set, &commands](size_t job)
+        {
+            auto& buffer{ commands.buffer(job) };
+            for (size_t i{ job }; i < set.size(); i += NUM_JOBS)
+            {
+                uint32_t const key{ set.dense()[i] };
+                if (key % 3 == 0)
+                {
+                    buffer.erase(key);
+                }
+                else if (key % 3 == 1)
+                {
+                    buffer.replace(key, set.data()[i] + "!");
+                }
+                else
+                {
+                    buffer.emplace(key + NUM_KEYS, set.data()[i]);
+                }
+            }
+        });
+
+    //Conflicting commands for one key resolve in buffer order: job 0 erases key 0 and job 1 emplaces it again
+    commands.buffer(1).emplace(0, "zero");
+
+    std::cout << "recorded: " << commands.size() << ", size before flush: " << set.size() << "\n";
+
+    auto const result{ commands.flush(set) };
+    std::cout << "emplaced: " << result.emplaced << ", replaced: " << result.replaced << ", erased: " << result.erased
+              << ", size: " << set.size() << ", [0]: " << set[0] << ", [1]: " << set[1] << ", [" << NUM_KEYS + 2 << "]: " << set[NUM_KEYS + 2] << "\n";
+
+    //Buffers of the calling threads
+    std::vector<std::jthread> threads{};
+    for (uint32_t t{ 0 }; t < 4; ++t)
+    {
+        threads.emplace_back([&commands, t]()
+            {
+                for (uint32_t key{ t }; key < NUM_KEYS; key += 4)
+                {
+                    commands.local().erase(key);
+                }
+            });
+    }
+    threads.clear();
+
+    auto const localResult{ commands.flush(set) };
+    std::cout << "local erased: " << localResult.erased << ", size: " << set.size() << ", pending: " << commands.size() << "\n";
+}
+
+void TestStats()
+{
+    std::cout << "\nSTATS\n";
+
+    Internal::sparse_set<int, uint32_t, Internal::flat_sparse, std::allocator<int>, uint32_t, Internal::no_change_tracking, Internal::collect_stats> set{ };
+    for (uint32_t i{ 0 }; i < 1000; ++i)
+    {
+        set.emplace(i * 4, static_cast<int>(1000 - i));
+    }
+    for (uint32_t i{ 0 }; i < 100; ++i)
+    {
+        set.erase(i * 8);
+    }
+    for (uint32_t key{ 0 }; key < 100; ++key)
+    {
+        (void)set.contains(key);
+    }
+    set.sort();
+
+    auto const counters{ set.stats() };
+    std::cout << "emplaces: " << counters.emplaces << ", erases: " << counters.erases << ", erase moves: " << counters.eraseMoves
+              << ", sparse resizes: " << counters.sparseResizes << ", dense resizes: " << counters.denseResizes << "\n"
+              << "sorts: " << counters.sorts << ", sort moves: " << counters.sortMoves << ", lookup misses: " << counters.lookupMisses << "\n";
+
+    auto const usage{ set.memory_usage() };
+    std::cout << "sparse: " << usage.sparseBytes << " bytes for " << usage.sparseSlots << " slots, occupancy: " << usage.sparseOccupancy << "\n"
+              << "dense: " << usage.denseBytes << " / " << usage.denseCapacityBytes << ", packed: " << usage.packedBytes << " / " << usage.packedCapacityBytes
+              << ", sort buffers: " << usage.sortBufferBytes << ", total: " << usage.total_bytes() << "\n";
+
+    set.reset_stats();
+    std::cout << "after reset: " << set.stats().emplaces << ", plain size: " << sizeof(Internal::sparse_set<int>) << ", with stats: " << sizeof(set) << "\n";
+
+    //A bulk insert into an empty set allocates every storage once
+    decltype(set) bulk{ };
+    std::vector<uint32_t> keys{ 1, 5, 9, 13 };
+    std::vector<int> values{ 1, 2, 3, 4 };
+    bulk.emplace_bulk(keys, values);
+    auto const bulkCounters{ bulk.stats() };
+    std::cout << "bulk emplace counted once: " << std::boolalpha
+              << (bulkCounters.emplaces == 4 && bulkCounters.denseResizes == 1 && bulkCounters.sparseResizes == 1 && bulkCounters.lookupMisses == 0) << "\n";
+
+    //Inserting new keys is not a lookup miss, only the explicit probe of key 2 is
+    std::vector<uint32_t> tryKeys{ 5, 2, 3, 4 };
+    std::vector<int> tryValues{ 5, 6, 7, 8 };
+    bulk.reset_stats();
+    size_t const added{ bulk.try_emplace_bulk(tryKeys, tryValues) };
+    bulk.try_emplace(20, 9);
+    bulk.get_or_emplace(21, 10);
+    bulk.remove(2);
+    (void)bulk.contains(2);
+    auto const tryCounters{ bulk.stats() };
+    std::cout << "try inserts without misses: " << std::boolalpha
+              << (added == 3 && tryCounters.emplaces == 5 && tryCounters.erases == 1 && tryCounters.lookupMisses == 1) << "\n";
+}
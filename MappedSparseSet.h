@@ -0,0 +1,296 @@
+#ifndef MAPPED_SPARSE_SET
+#define MAPPED_SPARSE_SET
+
+#include <span>
+#include <filesystem>
+#include <type_traits>
+#include <functional>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	namespace Impl
+	{
+		//Read only mapping of a whole file, unmapped on destruction
+		class file_mapping final
+		{
+		public:
+			file_mapping() noexcept = default;
+
+			explicit file_mapping(const std::filesystem::path& path)
+			{
+#if defined(_WIN32)
+				HANDLE const file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+				if (file == INVALID_HANDLE_VALUE)
+				{
+					throw sparse_set_snapshot_error{ "Can not open snapshot for mapping", path };
+				}
+
+				LARGE_INTEGER size{ };
+				if (!GetFileSizeEx(file, &size))
+				{
+					CloseHandle(file);
+					throw sparse_set_snapshot_error{ "Can not read the snapshot size", path };
+				}
+				m_Size = static_cast<size_t>(size.QuadPart);
+
+				if (m_Size > 0)
+				{
+					HANDLE const mapping{ CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+					CloseHandle(file);
+					if (!mapping)
+					{
+						throw sparse_set_snapshot_error{ "Can not map snapshot", path };
+					}
+
+					//The view keeps the mapping alive
+					m_Data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+					CloseHandle(mapping);
+				}
+				else
+				{
+					CloseHandle(file);
+				}
+#else
+				int const file{ ::open(path.c_str(), O_RDONLY) };
+				if (file < 0)
+				{
+					throw sparse_set_snapshot_error{ "Can not open snapshot for mapping", path };
+				}
+
+				struct stat info{ };
+				if (::fstat(file, &info) != 0)
+				{
+					::close(file);
+					throw sparse_set_snapshot_error{ "Can not read the snapshot size", path };
+				}
+				m_Size = static_cast<size_t>(info.st_size);
+
+				if (m_Size > 0)
+				{
+					void* const data{ ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0) };
+					m_Data = (data != MAP_FAILED) ? static_cast<const std::byte*>(data) : nullptr;
+				}
+				::close(file);
+#endif
+
+				if (m_Size > 0 && !m_Data)
+				{
+					throw sparse_set_snapshot_error{ "Can not map snapshot", path };
+				}
+			}
+
+			~file_mapping() noexcept
+			{
+				unmap();
+			}
+
+			file_mapping(const file_mapping&) = delete;
+			file_mapping& operator=(const file_mapping&) = delete;
+
+			file_mapping(file_mapping&& other) noexcept :
+				m_Data{ std::exchange(other.m_Data, nullptr) },
+				m_Size{ std::exchange(other.m_Size, 0) }
+			{ }
+
+			file_mapping& operator=(file_mapping&& other) noexcept
+			{
+				if (this != &other)
+				{
+					unmap();
+					m_Data = std::exchange(other.m_Data, nullptr);
+					m_Size = std::exchange(other.m_Size, 0);
+				}
+				return *this;
+			}
+
+			[[nodiscard]] const std::byte* data() const noexcept { return m_Data; }
+			[[nodiscard]] size_t size() const noexcept { return m_Size; }
+
+		private:
+			const std::byte* m_Data{ nullptr };
+			size_t m_Size{ 0 };
+
+			void unmap() noexcept
+			{
+				if (!m_Data)
+				{
+					return;
+				}
+
+#if defined(_WIN32)
+				UnmapViewOfFile(m_Data);
+#else
+				::munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+				m_Data = nullptr;
+				m_Size = 0;
+			}
+		};
+	}
+
+	//Read only view of a snapshot written by sparse_set::save with the flat sparse policy.
+	//Maps the file and serves lookups and iteration straight from the mapping, nothing is deserialized or copied,
+	//pages are only read once they are touched. The types must match the ones the snapshot was written with.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t, Impl::KeyType DenseIndex = KeyType>
+	requires std::is_trivially_copyable_v<Val>
+	class mapped_sparse_set final
+	{
+	public:
+		using key_type = KeyType;
+		using dense_type = DenseIndex;
+		using value_type = Val;
+
+		using const_iterator = const Val*;
+		using iterator = const_iterator;
+		using const_items_range = Impl::items_range<KeyType, const Val>;
+
+		//Checking the block checksums reads the whole file, skip it to keep the startup cost independent of the set size
+		explicit mapped_sparse_set(const std::filesystem::path& path, bool verifyChecksums = true) :
+			m_File{ path }
+		{
+			Impl::snapshot_header header{ };
+			if (m_File.size() < sizeof(header))
+			{
+				throw sparse_set_snapshot_error{ "Snapshot is truncated", path };
+			}
+			std::memcpy(&header, m_File.data(), sizeof(header));
+
+			Impl::validate_snapshot_header(header, m_File.size(), sizeof(KeyType), sizeof(DenseIndex), sizeof(Val), alignof(Val), path);
+			if (header.count > 0 && header.sparseCount == 0)
+			{
+				throw sparse_set_snapshot_error{ "Snapshot has no flat sparse array to map", path };
+			}
+
+			//The mapping starts on a page boundary and the blocks on 64 byte boundaries, so every block is aligned for its type
+			m_Sparse = { reinterpret_cast<const DenseIndex*>(m_File.data() + header.sparseOffset), static_cast<size_t>(header.sparseCount) };
+			m_Dense = { reinterpret_cast<const KeyType*>(m_File.data() + header.denseOffset), static_cast<size_t>(header.count) };
+			m_Values = { reinterpret_cast<const Val*>(m_File.data() + header.valuesOffset), static_cast<size_t>(header.count) };
+
+			if (verifyChecksums && (Impl::snapshot_checksum(m_Sparse.data(), m_Sparse.size_bytes()) != header.sparseChecksum
+				|| Impl::snapshot_checksum(m_Dense.data(), m_Dense.size_bytes()) != header.denseChecksum
+				|| Impl::snapshot_checksum(m_Values.data(), m_Values.size_bytes()) != header.valuesChecksum))
+			{
+				throw sparse_set_snapshot_error{ "Snapshot block is corrupted", path };
+			}
+		}
+
+		~mapped_sparse_set() noexcept = default;
+
+		mapped_sparse_set(const mapped_sparse_set&) = delete;
+		mapped_sparse_set& operator=(const mapped_sparse_set&) = delete;
+		mapped_sparse_set(mapped_sparse_set&& other) noexcept :
+			m_File{ std::move(other.m_File) },
+			m_Sparse{ std::exchange(other.m_Sparse, { }) },
+			m_Dense{ std::exchange(other.m_Dense, { }) },
+			m_Values{ std::exchange(other.m_Values, { }) }
+		{ }
+
+		mapped_sparse_set& operator=(mapped_sparse_set&& other) noexcept
+		{
+			if (this != &other)
+			{
+				m_File = std::move(other.m_File);
+				m_Sparse = std::exchange(other.m_Sparse, { });
+				m_Dense = std::exchange(other.m_Dense, { });
+				m_Values = std::exchange(other.m_Values, { });
+			}
+			return *this;
+		}
+
+	public:
+		const_iterator begin() const noexcept { return m_Values.data(); }
+		const_iterator end() const noexcept { return m_Values.data() + m_Values.size(); }
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		[[nodiscard]] const_items_range items() const noexcept { return { m_Dense.data(), m_Values.data(), m_Dense.size() }; }
+
+		//Calls func(key, Val const&) for every element in dense order
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val const&>
+		void each(Func&& func) const
+		{
+			for (size_t i{ 0 }; i < m_Dense.size(); ++i)
+			{
+				std::invoke(func, m_Dense[i], m_Values[i]);
+			}
+		}
+
+	public:
+		[[nodiscard]] size_t size() const noexcept { return m_Dense.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_Dense.empty(); }
+		[[nodiscard]] size_t sparse_size() const noexcept { return m_Sparse.size(); }
+
+		std::span<const DenseIndex> sparse() const noexcept { return m_Sparse; }
+		std::span<const KeyType> dense() const noexcept { return m_Dense; }
+		std::span<const Val> data() const noexcept { return m_Values; }
+
+	public:
+		[[nodiscard]] bool contains(KeyType element) const noexcept
+		{
+			return element < m_Sparse.size() && m_Sparse[element] != INVALID_INDEX;
+		}
+
+		//Element must exist to get a valid value
+		[[nodiscard]] DenseIndex index(KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_Sparse[element];
+		}
+
+		//Element must exist to get a valid value
+		Val const& operator[](KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_Values[m_Sparse[element]];
+		}
+
+		//Random access with bounds checking (similar to std::vector:::at())
+		Val const& at(KeyType element) const
+		{
+			if (contains(element))
+			{
+				return m_Values[m_Sparse[element]];
+			}
+			throw sparse_set_out_of_range("Element not found in mapped_sparse_set", element);
+		}
+
+		[[nodiscard]] const_iterator find(KeyType element) const noexcept
+		{
+			return contains(element) ? begin() + m_Sparse[element] : end();
+		}
+
+	private:
+		static constexpr DenseIndex INVALID_INDEX = std::numeric_limits<DenseIndex>::max();
+
+		Impl::file_mapping m_File{ };
+
+		std::span<const DenseIndex> m_Sparse{ };
+		std::span<const KeyType> m_Dense{ };
+		std::span<const Val> m_Values{ };
+	};
+}
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef SPARSE_SET_PARALLEL
+#define SPARSE_SET_PARALLEL
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <latch>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "InternalAssert.h"
+
+namespace Internal
+{
+	namespace Impl
+	{
+		inline constexpr size_t CACHE_LINE_SIZE{ 64 };
+
+		//0 means one thread per hardware thread
+		[[nodiscard]] inline size_t resolve_thread_count(size_t threadCount) noexcept
+		{
+			if (threadCount == 0)
+			{
+				threadCount = std::thread::hardware_concurrency();
+			}
+			return std::max<size_t>(threadCount, 1);
+		}
+
+		//Anything tasks can be handed to, e.g. thread_pool or a wrapper around an existing job system
+		template<typename E>
+		concept Executor = requires(E& executor, std::function<void()> task)
+		{
+			executor.submit(std::move(task));
+		};
+	}
+
+	//Work stealing thread pool, every worker pops its own queue from the back and steals from the front of the other queues.
+	class thread_pool final
+	{
+	public:
+		//0 means one worker per hardware thread
+		explicit thread_pool(size_t threadCount = 0)
+		{
+			threadCount = Impl::resolve_thread_count(threadCount);
+
+			m_Queues.reserve(threadCount);
+			for (size_t i{ 0 }; i < threadCount; ++i)
+			{
+				m_Queues.emplace_back(std::make_unique<worker_queue>());
+			}
+
+			m_Workers.reserve(threadCount);
+			for (size_t i{ 0 }; i < threadCount; ++i)
+			{
+				m_Workers.emplace_back([this, i]() { worker_loop(i); });
+			}
+		}
+
+		~thread_pool() noexcept
+		{
+			{
+				std::scoped_lock const lock{ m_SleepMutex };
+				m_Stop = true;
+			}
+			m_Wake.notify_all();
+			m_Workers.clear();
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+		thread_pool(thread_pool&&) = delete;
+		thread_pool& operator=(thread_pool&&) = delete;
+
+	public:
+		[[nodiscard]] size_t thread_count() const noexcept { return m_Workers.size(); }
+
+		//Tasks submitted from a worker go to its own queue, other threads spread their tasks round robin
+		void submit(std::function<void()> task)
+		{
+			size_t const queue{ (t_Pool == this) ? t_WorkerIndex : m_NextQueue.fetch_add(1, std::memory_order_relaxed) % m_Queues.size() };
+
+			{
+				std::scoped_lock const lock{ m_Queues[queue]->mutex };
+				m_Queues[queue]->tasks.emplace_back(std::move(task));
+			}
+
+			{
+				std::scoped_lock const lock{ m_SleepMutex };
+				++m_Pending;
+			}
+			m_Wake.notify_one();
+		}
+
+		//Runs one queued task on the calling thread, returns false when there was nothing to run.
+		//Lets a thread that waits on tasks help instead of blocking.
+		bool try_run_one()
+		{
+			size_t const start{ (t_Pool == this) ? t_WorkerIndex : 0 };
+
+			std::function<void()> task{ };
+			if (!try_pop(start, task))
+			{
+				return false;
+			}
+
+			task();
+			return true;
+		}
+
+	private:
+		struct worker_queue final
+		{
+			std::mutex mutex{ };
+			std::deque<std::function<void()>> tasks{ };
+		};
+
+		std::vector<std::unique_ptr<worker_queue>> m_Queues{ };
+		std::vector<std::jthread> m_Workers{ };
+
+		std::atomic<size_t> m_NextQueue{ 0 };
+
+		std::mutex m_SleepMutex{ };
+		std::condition_variable m_Wake{ };
+		size_t m_Pending{ 0 };
+		bool m_Stop{ false };
+
+		static inline thread_local thread_pool* t_Pool{ nullptr };
+		static inline thread_local size_t t_WorkerIndex{ 0 };
+
+		//Own queue first (newest task), then steal the oldest task of the other queues
+		bool try_pop(size_t own, std::function<void()>& task)
+		{
+			for (size_t i{ 0 }; i < m_Queues.size(); ++i)
+			{
+				worker_queue& queue{ *m_Queues[(own + i) % m_Queues.size()] };
+
+				std::unique_lock lock{ queue.mutex };
+				if (queue.tasks.empty())
+				{
+					continue;
+				}
+
+				if (i == 0)
+				{
+					task = std::move(queue.tasks.back());
+					queue.tasks.pop_back();
+				}
+				else
+				{
+					task = std::move(queue.tasks.front());
+					queue.tasks.pop_front();
+				}
+				lock.unlock();
+
+				std::scoped_lock const sleepLock{ m_SleepMutex };
+				--m_Pending;
+				return true;
+			}
+
+			return false;
+		}
+
+		void worker_loop(size_t index)
+		{
+			t_Pool = this;
+			t_WorkerIndex = index;
+
+			std::function<void()> task{ };
+			while (true)
+			{
+				if (try_pop(index, task))
+				{
+					task();
+					task = nullptr;
+					continue;
+				}
+
+				std::unique_lock lock{ m_SleepMutex };
+				m_Wake.wait(lock, [this]() { return m_Stop || m_Pending > 0; });
+				if (m_Stop)
+				{
+					return;
+				}
+			}
+		}
+	};
+
+	//Pool used by the parallel members of the containers when no executor is passed
+	[[nodiscard]] inline thread_pool& default_thread_pool()
+	{
+		static thread_pool pool{ };
+		return pool;
+	}
+
+	namespace Impl
+	{
+		//Runs func(chunk) for every chunk in [0, chunkCount) on the executor and waits for all of them.
+		//The calling thread runs the last chunk itself and helps draining the pool while it waits.
+		template<Executor E, typename Func>
+		void run_chunks(E& executor, size_t chunkCount, Func&& func)
+		{
+			if (chunkCount == 0)
+			{
+				return;
+			}
+
+			std::latch done{ static_cast<std::ptrdiff_t>(chunkCount - 1) };
+			for (size_t chunk{ 0 }; chunk + 1 < chunkCount; ++chunk)
+			{
+				executor.submit([&func, &done, chunk]()
+					{
+						func(chunk);
+						done.count_down();
+					});
+			}
+
+			func(chunkCount - 1);
+
+			while (!done.try_wait())
+			{
+				if constexpr (requires { executor.try_run_one(); })
+				{
+					if (!executor.try_run_one())
+					{
+						std::this_thread::yield();
+					}
+				}
+				else
+				{
+					done.wait();
+				}
+			}
+		}
+
+		//First index at or after pos whose element starts a new cache line, so neighbouring chunks never write the same line.
+		//Falls back to pos for element sizes that do not tile a cache line.
+		[[nodiscard]] inline size_t cache_line_boundary(const void* base, size_t elementSize, size_t pos) noexcept
+		{
+			if (elementSize == 0 || elementSize > CACHE_LINE_SIZE || CACHE_LINE_SIZE % elementSize != 0)
+			{
+				return pos;
+			}
+
+			auto const address{ reinterpret_cast<std::uintptr_t>(base) + pos * elementSize };
+			auto const misalignment{ address % CACHE_LINE_SIZE };
+			if (misalignment == 0 || misalignment % elementSize != 0)
+			{
+				return pos;
+			}
+
+			return pos + (CACHE_LINE_SIZE - misalignment) / elementSize;
+		}
+	}
+}
+
+#endif
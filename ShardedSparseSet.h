@@ -0,0 +1,408 @@
+#ifndef SHARDED_SPARSE_SET
+#define SHARDED_SPARSE_SET
+
+#include <shared_mutex>
+#include <mutex>
+#include <memory>
+#include <optional>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <functional>
+#include <utility>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	//Splits the key space over Shards independent sparse_sets, each behind its own lock, so threads that write different shards never wait on each other.
+	//A key belongs to shard key % Shards and is stored there as key / Shards, consecutive keys spread over all shards
+	//and every shard only holds a sparse array for its own part of the key space.
+	//Every member is thread-safe except items(), which must only be iterated while no thread writes.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t, size_t Shards = 16, Impl::SparsePolicy<KeyType> SparsePolicy = flat_sparse>
+	requires (Shards > 0 && (Shards & (Shards - 1)) == 0)
+	class sharded_sparse_set final
+	{
+		struct shard final
+		{
+			mutable std::shared_mutex mutex{ };
+			sparse_set<Val, KeyType, SparsePolicy> set{ };
+			//Keeps the lock of the next shard off the cache lines of this one
+			char padding[Impl::CACHE_LINE_SIZE]{ };
+		};
+
+	public:
+		template<bool IsConst>
+		class basic_items_iterator;
+		template<bool IsConst>
+		class basic_items_range;
+
+		using key_type = KeyType;
+		using value_type = Val;
+		using shard_type = sparse_set<Val, KeyType, SparsePolicy>;
+		using items_range = basic_items_range<false>;
+		using const_items_range = basic_items_range<true>;
+
+		static constexpr size_t SHARD_COUNT{ Shards };
+
+		sharded_sparse_set() :
+			m_Shards{ std::make_unique<shard[]>(Shards) }
+		{ }
+
+		~sharded_sparse_set() noexcept = default;
+
+		sharded_sparse_set(const sharded_sparse_set&) = delete;
+		sharded_sparse_set& operator=(const sharded_sparse_set&) = delete;
+		sharded_sparse_set(sharded_sparse_set&&) noexcept = default;
+		sharded_sparse_set& operator=(sharded_sparse_set&&) noexcept = default;
+
+	public:
+		[[nodiscard]] static constexpr size_t shard_of(KeyType key) noexcept
+		{
+			return static_cast<size_t>(key) & (Shards - 1);
+		}
+
+		//Key the element is stored under inside its shard
+		[[nodiscard]] static constexpr KeyType local_key(KeyType key) noexcept
+		{
+			return static_cast<KeyType>(key >> SHARD_BITS);
+		}
+
+		[[nodiscard]] static constexpr KeyType global_key(size_t shard, KeyType local) noexcept
+		{
+			return static_cast<KeyType>((local << SHARD_BITS) | static_cast<KeyType>(shard));
+		}
+
+	public:
+		//Emplaces the element unless the key is already in the set, returns whether it was emplaced
+		template<typename... Args>
+		bool try_emplace(KeyType key, Args&&... args) noexcept
+		{
+			shard& target{ m_Shards[shard_of(key)] };
+			std::unique_lock const lock{ target.mutex };
+
+			if (target.set.contains(local_key(key)))
+			{
+				return false;
+			}
+
+			target.set.emplace(local_key(key), std::forward<Args>(args)...);
+			return true;
+		}
+
+		//Element must not be in the set yet
+		template<typename... Args>
+		void emplace(KeyType key, Args&&... args) noexcept
+		{
+			shard& target{ m_Shards[shard_of(key)] };
+			std::unique_lock const lock{ target.mutex };
+			target.set.emplace(local_key(key), std::forward<Args>(args)...);
+		}
+
+		//Do not erase an element that does not exist, use remove instead if this is a concern.
+		void erase(KeyType key) noexcept
+		{
+			shard& target{ m_Shards[shard_of(key)] };
+			std::unique_lock const lock{ target.mutex };
+			target.set.erase(local_key(key));
+		}
+
+		bool remove(KeyType key) noexcept
+		{
+			shard& target{ m_Shards[shard_of(key)] };
+			std::unique_lock const lock{ target.mutex };
+			return target.set.remove(local_key(key));
+		}
+
+		[[nodiscard]] bool contains(KeyType key) const noexcept
+		{
+			shard const& target{ m_Shards[shard_of(key)] };
+			std::shared_lock const lock{ target.mutex };
+			return target.set.contains(local_key(key));
+		}
+
+		//Element must exist to get a valid value. Returns a copy, a reference would outlive the lock of the shard
+		[[nodiscard]] Val operator[](KeyType key) const
+		{
+			shard const& target{ m_Shards[shard_of(key)] };
+			std::shared_lock const lock{ target.mutex };
+			return target.set[local_key(key)];
+		}
+
+		//Copy with bounds checking (similar to std::vector:::at())
+		[[nodiscard]] Val at(KeyType key) const
+		{
+			if (std::optional<Val> value{ get(key) })
+			{
+				return std::move(*value);
+			}
+			throw sparse_set_out_of_range("Element not found in sharded_sparse_set", key);
+		}
+
+		//Copy of the value, nullopt when the key is not in the set
+		[[nodiscard]] std::optional<Val> get(KeyType key) const
+		{
+			shard const& target{ m_Shards[shard_of(key)] };
+			std::shared_lock const lock{ target.mutex };
+			return target.set.contains(local_key(key)) ? std::optional<Val>{ target.set[local_key(key)] } : std::nullopt;
+		}
+
+		//Calls func(Val&) under the lock of the shard, returns false when the key is not in the set
+		template<typename Func>
+		requires std::is_invocable_v<Func&, Val&>
+		bool visit(KeyType key, Func&& func)
+		{
+			shard& target{ m_Shards[shard_of(key)] };
+			std::unique_lock const lock{ target.mutex };
+
+			if (!target.set.contains(local_key(key)))
+			{
+				return false;
+			}
+
+			std::invoke(func, target.set[local_key(key)]);
+			return true;
+		}
+
+		//Calls func(Val const&) under the shared lock of the shard, returns false when the key is not in the set
+		template<typename Func>
+		requires std::is_invocable_v<Func&, Val const&>
+		bool visit(KeyType key, Func&& func) const
+		{
+			shard const& target{ m_Shards[shard_of(key)] };
+			std::shared_lock const lock{ target.mutex };
+
+			if (!target.set.contains(local_key(key)))
+			{
+				return false;
+			}
+
+			std::invoke(func, target.set[local_key(key)]);
+			return true;
+		}
+
+		//Calls func(shard_type&) under the lock of one shard, e.g. to insert a batch of keys of that shard or to sort it.
+		//The shard holds local keys, see local_key and global_key.
+		template<typename Func>
+		requires std::is_invocable_v<Func&, shard_type&>
+		decltype(auto) with_shard(size_t index, Func&& func)
+		{
+			ASSERT(index < Shards, "Shard out of range!");
+			std::unique_lock const lock{ m_Shards[index].mutex };
+			return std::invoke(func, m_Shards[index].set);
+		}
+
+	public:
+		//Sum of the shard sizes, each shard is counted under its own lock so concurrent writes can make it stale
+		[[nodiscard]] size_t size() const noexcept
+		{
+			size_t count{ 0 };
+			for (size_t index{ 0 }; index < Shards; ++index)
+			{
+				std::shared_lock const lock{ m_Shards[index].mutex };
+				count += m_Shards[index].set.size();
+			}
+			return count;
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		void clear() noexcept
+		{
+			for_each_shard([](shard_type& set) { set.clear(); });
+		}
+
+		//Spreads the capacity evenly over the shards
+		void reserve(size_t newCap) noexcept
+		{
+			for_each_shard([newCap](shard_type& set) { set.reserve(static_cast<KeyType>((newCap + Shards - 1) / Shards)); });
+		}
+
+		void shrink_to_fit() noexcept
+		{
+			for_each_shard([](shard_type& set) { set.shrink_to_fit(); });
+		}
+
+	public:
+		//Calls func(key, Val&) for every element, one shard at a time under its lock
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void each(Func&& func)
+		{
+			for (size_t index{ 0 }; index < Shards; ++index)
+			{
+				std::unique_lock const lock{ m_Shards[index].mutex };
+				each_in_shard(index, func);
+			}
+		}
+
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val const&>
+		void each(Func&& func) const
+		{
+			for (size_t index{ 0 }; index < Shards; ++index)
+			{
+				std::shared_lock const lock{ m_Shards[index].mutex };
+				each_in_shard(index, func);
+			}
+		}
+
+		//Calls func(key, Val&) for every element, the shards run in parallel on the executor (the built-in pool by default), each under its lock.
+		//func runs concurrently for elements of different shards.
+		template<Impl::Executor Executor, typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void parallel_each(Executor& executor, Func&& func)
+		{
+			Impl::run_chunks(executor, Shards, [this, &func](size_t index)
+				{
+					std::unique_lock const lock{ m_Shards[index].mutex };
+					each_in_shard(index, func);
+				});
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void parallel_each(Func&& func)
+		{
+			parallel_each(default_thread_pool(), std::forward<Func>(func));
+		}
+
+		//Calls func(Val&) for every value, the shards run in parallel on the executor (the built-in pool by default), each under its lock
+		template<Impl::Executor Executor, typename Func>
+		requires std::is_invocable_v<Func&, Val&>
+		void parallel_for_each(Executor& executor, Func&& func)
+		{
+			Impl::run_chunks(executor, Shards, [this, &func](size_t index)
+				{
+					std::unique_lock const lock{ m_Shards[index].mutex };
+					for (Val& value : m_Shards[index].set)
+					{
+						std::invoke(func, value);
+					}
+				});
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, Val&>
+		void parallel_for_each(Func&& func)
+		{
+			parallel_for_each(default_thread_pool(), std::forward<Func>(func));
+		}
+
+	public:
+		//Yields (key, Val&) pairs
+		template<bool IsConst>
+		class basic_items_iterator final
+		{
+			using shard_pointer = std::conditional_t<IsConst, const shard*, shard*>;
+			using value_ref = std::conditional_t<IsConst, Val const&, Val&>;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using iterator_concept = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = std::pair<KeyType, value_ref>;
+			using reference = value_type;
+			using pointer = void;
+
+			basic_items_iterator() noexcept = default;
+			basic_items_iterator(shard_pointer shards, size_t index) noexcept :
+				m_Shards{ shards },
+				m_Index{ index }
+			{
+				skip_empty();
+			}
+
+			[[nodiscard]] reference operator*() const noexcept
+			{
+				auto&& [key, value] { m_Shards[m_Index].set.items()[static_cast<std::ptrdiff_t>(m_Pos)] };
+				return { global_key(m_Index, key), value };
+			}
+
+			basic_items_iterator& operator++() noexcept
+			{
+				++m_Pos;
+				skip_empty();
+				return *this;
+			}
+			basic_items_iterator operator++(int) noexcept { basic_items_iterator const temp{ *this }; ++(*this); return temp; }
+
+			[[nodiscard]] bool operator==(const basic_items_iterator& other) const noexcept { return m_Index == other.m_Index && m_Pos == other.m_Pos; }
+
+		private:
+			shard_pointer m_Shards{ nullptr };
+			size_t m_Index{ Shards };
+			size_t m_Pos{ 0 };
+
+			void skip_empty() noexcept
+			{
+				while (m_Index < Shards && m_Pos >= m_Shards[m_Index].set.size())
+				{
+					++m_Index;
+					m_Pos = 0;
+				}
+			}
+		};
+
+		//Forward range over the elements of every shard as (key, Val&) pairs, shard by shard in dense order
+		template<bool IsConst>
+		class basic_items_range final : public std::ranges::view_interface<basic_items_range<IsConst>>
+		{
+			using shard_pointer = std::conditional_t<IsConst, const shard*, shard*>;
+
+		public:
+			using iterator = basic_items_iterator<IsConst>;
+
+			basic_items_range() noexcept = default;
+			explicit basic_items_range(shard_pointer shards) noexcept :
+				m_Shards{ shards }
+			{ }
+
+			[[nodiscard]] iterator begin() const noexcept { return iterator{ m_Shards, 0 }; }
+			[[nodiscard]] iterator end() const noexcept { return iterator{ m_Shards, Shards }; }
+
+		private:
+			shard_pointer m_Shards{ nullptr };
+		};
+
+		//Merged view over all shards, takes no locks. Only iterate while no thread writes, e.g. once ingest is done.
+		[[nodiscard]] items_range items() noexcept { return items_range{ m_Shards.get() }; }
+		[[nodiscard]] const_items_range items() const noexcept { return const_items_range{ m_Shards.get() }; }
+
+	private:
+		static constexpr size_t SHARD_BITS{ static_cast<size_t>(std::countr_zero(Shards)) };
+
+		std::unique_ptr<shard[]> m_Shards;
+
+		//The shard must be locked
+		template<typename Func>
+		void each_in_shard(size_t index, Func& func)
+		{
+			for (auto [key, value] : m_Shards[index].set.items())
+			{
+				std::invoke(func, global_key(index, key), value);
+			}
+		}
+		template<typename Func>
+		void each_in_shard(size_t index, Func& func) const
+		{
+			for (auto [key, value] : std::as_const(m_Shards[index].set).items())
+			{
+				std::invoke(func, global_key(index, key), value);
+			}
+		}
+
+		template<typename Func>
+		void for_each_shard(Func&& func)
+		{
+			for (size_t index{ 0 }; index < Shards; ++index)
+			{
+				std::unique_lock const lock{ m_Shards[index].mutex };
+				func(m_Shards[index].set);
+			}
+		}
+	};
+}
+
+#endif
@@ -2,6 +2,8 @@
 #define SPARSE_SET
 
 #include <vector>
+#include <span>
+#include <array>
 
 #include <type_traits>
 #include <limits>
@@ -10,8 +12,21 @@
 #include <string>
 #include <algorithm>
 #include <numeric>
+#include <functional>
+#include <cstring>
+#include <bit>
+#include <optional>
+#include <memory>
+#include <memory_resource>
+#include <iterator>
+#include <ranges>
 
 #include "InternalAssert.h"
+#include "SparseStorage.h"
+#include "ChangeTracking.h"
+#include "SparseSetStats.h"
+#include "SparseSetSnapshot.h"
+#include "Parallel.h"
 
 namespace Internal
 {
@@ -33,14 +48,145 @@ namespace Internal
 		template<typename T>
 		concept ValType =  (std::is_trivially_copyable_v<T> || MoveAssignmentVal<T> || MoveConstructVal<T>);
 
+		//Integral sort keys that can be radix sorted
+		template<typename T>
+		concept RadixKey = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+		//Moves src into the live value dst
+		template<ValType Val>
+		void assign_value(Val& dst, Val&& src) noexcept
+		{
+			if constexpr (std::is_trivially_copyable_v<Val>)
+			{
+				std::memcpy(&dst, &src, sizeof(Val));
+			}
+			else if constexpr (MoveAssignmentVal<Val>)
+			{
+				dst = std::move(src);
+			}
+			else if constexpr (MoveConstructVal<Val>)
+			{
+				dst.~Val();
+				new (&dst) Val(std::move(src));
+			}
+		}
+
 		template <typename C, typename T>
 		concept Compare = requires(C comp, T a, T b) 
 		{
 			{ comp(a, b) } -> std::convertible_to<bool>;
 		};
 
+		//Sparse storage that keeps a presence bitset of its keys, see bitset_sparse
+		template<typename S>
+		concept PresenceStorage = requires(const S& storage)
+		{
+			storage.presence().test(size_t{ });
+		};
+
+		template<typename P, typename K>
+		concept SparsePolicy = requires(typename P::template storage_type<K, K, std::allocator<K>> storage, K key)
+		{
+			{ storage.contains(key) } -> std::convertible_to<bool>;
+			{ storage.get(key) } -> std::convertible_to<K>;
+			storage.get_many(&key, size_t{ }, &key);
+			storage.emplace(key, key);
+			storage.release(key);
+		};
+
+		//Gets notified by the sparse_sets it owns, used by owning groups to keep their sets co-sorted
+		template<typename KeyType>
+		class sparse_set_owner
+		{
+		public:
+			virtual ~sparse_set_owner() noexcept = default;
+
+			//Called after the element was emplaced
+			virtual void on_emplace(KeyType element) noexcept = 0;
+			//Called before the element is erased
+			virtual void on_erase(KeyType element) noexcept = 0;
+			//Called after the set was cleared
+			virtual void on_clear() noexcept = 0;
+		};
+
+		//Walks the dense keys and the packed values in lockstep, yields (key, Val&) pairs.
+		//Val is const for const sets, the iterator is two pointers so loops over it compile to plain pointer loops.
+		template<typename KeyType, typename Val>
+		class items_iterator final
+		{
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using iterator_concept = std::random_access_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = std::pair<KeyType, Val&>;
+			using reference = value_type;
+			using pointer = void;
+
+			items_iterator() noexcept = default;
+			items_iterator(const KeyType* key, Val* value) noexcept :
+				m_Key{ key },
+				m_Value{ value }
+			{ }
+
+			[[nodiscard]] reference operator*() const noexcept { return { *m_Key, *m_Value }; }
+			[[nodiscard]] reference operator[](difference_type offset) const noexcept { return { m_Key[offset], m_Value[offset] }; }
+
+			items_iterator& operator++() noexcept { ++m_Key; ++m_Value; return *this; }
+			items_iterator operator++(int) noexcept { items_iterator const temp{ *this }; ++(*this); return temp; }
+			items_iterator& operator--() noexcept { --m_Key; --m_Value; return *this; }
+			items_iterator operator--(int) noexcept { items_iterator const temp{ *this }; --(*this); return temp; }
+
+			items_iterator& operator+=(difference_type offset) noexcept { m_Key += offset; m_Value += offset; return *this; }
+			items_iterator& operator-=(difference_type offset) noexcept { m_Key -= offset; m_Value -= offset; return *this; }
+			[[nodiscard]] items_iterator operator+(difference_type offset) const noexcept { return items_iterator{ m_Key + offset, m_Value + offset }; }
+			[[nodiscard]] friend items_iterator operator+(difference_type offset, const items_iterator& it) noexcept { return it + offset; }
+			[[nodiscard]] items_iterator operator-(difference_type offset) const noexcept { return items_iterator{ m_Key - offset, m_Value - offset }; }
+			[[nodiscard]] difference_type operator-(const items_iterator& other) const noexcept { return m_Key - other.m_Key; }
+
+			[[nodiscard]] bool operator==(const items_iterator& other) const noexcept { return m_Key == other.m_Key; }
+			[[nodiscard]] auto operator<=>(const items_iterator& other) const noexcept { return m_Key <=> other.m_Key; }
+
+		private:
+			const KeyType* m_Key{ nullptr };
+			Val* m_Value{ nullptr };
+		};
+
+		//Random access range over (key, Val&) pairs in dense order, reverse with rbegin/rend or std::views::reverse.
+		//Only valid until the set is resized.
+		template<typename KeyType, typename Val>
+		class items_range final : public std::ranges::view_interface<items_range<KeyType, Val>>
+		{
+		public:
+			using iterator = items_iterator<KeyType, Val>;
+			using reverse_iterator = std::reverse_iterator<iterator>;
+
+			items_range() noexcept = default;
+			items_range(const KeyType* keys, Val* values, size_t size) noexcept :
+				m_Keys{ keys },
+				m_Values{ values },
+				m_Size{ size }
+			{ }
+
+			[[nodiscard]] iterator begin() const noexcept { return iterator{ m_Keys, m_Values }; }
+			[[nodiscard]] iterator end() const noexcept { return iterator{ m_Keys + m_Size, m_Values + m_Size }; }
+			[[nodiscard]] reverse_iterator rbegin() const noexcept { return reverse_iterator{ end() }; }
+			[[nodiscard]] reverse_iterator rend() const noexcept { return reverse_iterator{ begin() }; }
+
+			[[nodiscard]] size_t size() const noexcept { return m_Size; }
+
+			[[nodiscard]] std::span<const KeyType> keys() const noexcept { return { m_Keys, m_Size }; }
+			[[nodiscard]] std::span<Val> values() const noexcept { return { m_Values, m_Size }; }
+
+		private:
+			const KeyType* m_Keys{ nullptr };
+			Val* m_Values{ nullptr };
+			size_t m_Size{ 0 };
+		};
 	}
 
+	template<typename... Sets>
+	class owning_group;
+
 	template<Impl::KeyType KeyType>
 	class sparse_set_out_of_range : public std::out_of_range
 	{
@@ -61,13 +207,46 @@ namespace Internal
 		const KeyType m_Element;
 	};
 
-	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t>
+	//Smallest unsigned type that can index Capacity elements, the max value is kept free as the invalid index
+	template<size_t Capacity>
+	using dense_index_t = std::conditional_t<Capacity <= std::numeric_limits<uint8_t>::max(), uint8_t,
+						  std::conditional_t<Capacity <= std::numeric_limits<uint16_t>::max(), uint16_t,
+						  std::conditional_t<Capacity <= std::numeric_limits<uint32_t>::max(), uint32_t, uint64_t>>>;
+
+	//Allocator is rebound for the sparse, dense and packed arrays, each array can get its own allocator instance.
+	//DenseIndex is the type the sparse storage maps keys onto, a narrower type than KeyType shrinks the sparse storage
+	//but limits the set to max_size() elements, see dense_index_t.
+	//ChangeTracking selects whether the set journals its changes, see track_changes.
+	//Stats selects whether the set counts its operations, see collect_stats.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t, Impl::SparsePolicy<KeyType> SparsePolicy = flat_sparse, typename Allocator = std::allocator<Val>,
+			 Impl::KeyType DenseIndex = KeyType, Impl::ChangeTrackingPolicy<KeyType> ChangeTracking = no_change_tracking, Impl::StatsPolicy Stats = no_stats>
 	class sparse_set final
 	{
+		using alloc_traits = std::allocator_traits<Allocator>;
+
+		template<typename T>
+		using rebind_alloc = typename alloc_traits::template rebind_alloc<T>;
+
 	public:
 		sparse_set() noexcept = default;
 
-		sparse_set(std::initializer_list<std::pair<KeyType, Val&&>> initList, KeyType reserveSize = 0) noexcept
+		explicit sparse_set(const Allocator& alloc) noexcept :
+			sparse_set(alloc, alloc, alloc)
+		{ }
+
+		//Separate allocators for the sparse storage, the dense keys and the packed values (+ the sort buffers)
+		sparse_set(const Allocator& sparseAlloc, const Allocator& denseAlloc, const Allocator& packedAlloc) noexcept :
+			m_SparseArr(rebind_alloc<dense_type>{ sparseAlloc }),
+			m_DenseArr(rebind_alloc<KeyType>{ denseAlloc }),
+			m_PackedValArr(packedAlloc),
+			m_SortPerm(rebind_alloc<size_t>{ packedAlloc }),
+			m_SortKeys(rebind_alloc<uint64_t>{ packedAlloc }),
+			m_SortValues(packedAlloc),
+			m_Changes(rebind_alloc<KeyType>{ denseAlloc })
+		{ }
+
+		sparse_set(std::initializer_list<std::pair<KeyType, Val&&>> initList, KeyType reserveSize = 0, const Allocator& alloc = Allocator{ }) noexcept :
+			sparse_set(alloc)
 		{
 			sparse_reserve(static_cast<KeyType>(initList.size()));
 			reserve(reserveSize);
@@ -78,54 +257,86 @@ namespace Internal
 			}
 		}
 
-		sparse_set(KeyType sparseSize, KeyType reserveSize = 0) noexcept :
-			m_SparseArr(sparseSize, INVALID_INDEX)
+		sparse_set(KeyType sparseSize, KeyType reserveSize = 0, const Allocator& alloc = Allocator{ }) noexcept :
+			sparse_set(alloc)
 		{ 
+			m_SparseArr.resize(sparseSize);
 			reserve(reserveSize);
 		}
 
 		~sparse_set() noexcept = default;
 
+		//The arrays pick their allocators like the standard containers do (select_on_container_copy_construction / propagate_on_container_*)
 		sparse_set(const sparse_set& other) noexcept :
 			m_SparseArr{ other.m_SparseArr },
+			m_DenseArr{ other.m_DenseArr },
 			m_PackedValArr{ other.m_PackedValArr },
-			m_DenseArr{ other.m_DenseArr }
+			m_SortPerm(rebind_alloc<size_t>{ m_PackedValArr.get_allocator() }),
+			m_SortKeys(rebind_alloc<uint64_t>{ m_PackedValArr.get_allocator() }),
+			m_SortValues(m_PackedValArr.get_allocator()),
+			m_Changes{ other.m_Changes },
+			m_Stats{ other.m_Stats }
 		{ }
 
 		sparse_set& operator=(const sparse_set& other) noexcept
 		{
+			ASSERT(!m_Owner, "Can not copy into a set that is owned by a group!");
+
 			m_SparseArr = other.m_SparseArr;
-			m_PackedValArr = other.m_PackedValArr;
 			m_DenseArr = other.m_DenseArr;
+			m_PackedValArr = other.m_PackedValArr;
+			m_Changes = other.m_Changes;
+			m_Stats = other.m_Stats;
+			reset_sort_buffers();
 
 			return *this;
 		}
 
 		sparse_set(sparse_set&& other) noexcept :
 			m_SparseArr{ std::move(other.m_SparseArr) },
+			m_DenseArr{ std::move(other.m_DenseArr) },
 			m_PackedValArr{ std::move(other.m_PackedValArr) },
-			m_DenseArr{ std::move(other.m_DenseArr) }
-		{ }
+			m_SortPerm(rebind_alloc<size_t>{ m_PackedValArr.get_allocator() }),
+			m_SortKeys(rebind_alloc<uint64_t>{ m_PackedValArr.get_allocator() }),
+			m_SortValues(m_PackedValArr.get_allocator()),
+			m_Changes{ std::move(other.m_Changes) },
+			m_Stats{ std::move(other.m_Stats) }
+		{ 
+			ASSERT(!other.m_Owner, "Can not move a set that is owned by a group!");
+		}
 
+		//Arrays with allocators that do not propagate and do not compare equal move their elements one by one
 		sparse_set& operator=(sparse_set&& other) noexcept 
 		{
+			ASSERT(!m_Owner && !other.m_Owner, "Can not move a set that is owned by a group!");
+
 			m_SparseArr = std::move(other.m_SparseArr);
-			m_PackedValArr = std::move(other.m_PackedValArr);
 			m_DenseArr = std::move(other.m_DenseArr);
+			m_PackedValArr = std::move(other.m_PackedValArr);
+			m_Changes = std::move(other.m_Changes);
+			m_Stats = std::move(other.m_Stats);
+			reset_sort_buffers();
 
 			return *this;
 		}
 
 	public:
 		using key_type = KeyType;
-		using dense_type = KeyType;
+		using dense_type = DenseIndex;
 		using value_type = Val;
+		using sparse_policy = SparsePolicy;
+		using allocator_type = Allocator;
+		using sparse_storage = typename SparsePolicy::template storage_type<KeyType, dense_type, rebind_alloc<dense_type>>;
+		using dense_container = std::vector<KeyType, rebind_alloc<KeyType>>;
+		using packed_container = std::vector<Val, Allocator>;
+		using change_tracker = typename ChangeTracking::template tracker_type<KeyType, rebind_alloc<KeyType>>;
+		using stats_recorder = typename Stats::recorder_type;
 
-		using iterator = typename std::vector<Val>::iterator;
-		using const_iterator = typename std::vector<Val>::const_iterator;
+		using iterator = typename packed_container::iterator;
+		using const_iterator = typename packed_container::const_iterator;
 
-		using reverse_iterator = typename std::vector<Val>::reverse_iterator;
-		using const_reserve_iterator = typename std::vector<Val>::const_reverse_iterator;
+		using reverse_iterator = typename packed_container::reverse_iterator;
+		using const_reserve_iterator = typename packed_container::const_reverse_iterator;
 
 		iterator begin() noexcept { return m_PackedValArr.begin(); }
 		iterator end() noexcept { return m_PackedValArr.end(); }
@@ -142,12 +353,154 @@ namespace Internal
 		const_reserve_iterator crbegin() const noexcept { return m_PackedValArr.crbegin(); }
 		const_reserve_iterator crend() const noexcept { return m_PackedValArr.crend(); }
 
+	public:
+		using items_range = Impl::items_range<KeyType, Val>;
+		using const_items_range = Impl::items_range<KeyType, Val const>;
+
+		//(key, Val&) pairs in dense order, no sparse_index lookups needed to get the key of a value
+		[[nodiscard]] items_range items() noexcept { return { m_DenseArr.data(), m_PackedValArr.data(), m_DenseArr.size() }; }
+		[[nodiscard]] const_items_range items() const noexcept { return { m_DenseArr.data(), m_PackedValArr.data(), m_DenseArr.size() }; }
+
+		//Calls func(key, Val&) for every element in dense order
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void each(Func&& func)
+		{
+			KeyType const* const keys{ m_DenseArr.data() };
+			Val* const values{ m_PackedValArr.data() };
+			for (size_t i{ 0 }; i < m_DenseArr.size(); ++i)
+			{
+				std::invoke(func, keys[i], values[i]);
+			}
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val const&>
+		void each(Func&& func) const
+		{
+			KeyType const* const keys{ m_DenseArr.data() };
+			Val const* const values{ m_PackedValArr.data() };
+			for (size_t i{ 0 }; i < m_DenseArr.size(); ++i)
+			{
+				std::invoke(func, keys[i], values[i]);
+			}
+		}
+
+		//Calls func(key, Val&) for every element in ascending key order, walks the presence bitset so empty key ranges are skipped.
+		//Only available for the bitset_sparse policy.
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&> && Impl::PresenceStorage<sparse_storage>
+		void each_by_key(Func&& func)
+		{
+			m_SparseArr.presence().each([this, &func](size_t key)
+				{
+					std::invoke(func, static_cast<KeyType>(key), m_PackedValArr[m_SparseArr[static_cast<KeyType>(key)]]);
+				});
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val const&> && Impl::PresenceStorage<sparse_storage>
+		void each_by_key(Func&& func) const
+		{
+			m_SparseArr.presence().each([this, &func](size_t key)
+				{
+					std::invoke(func, static_cast<KeyType>(key), m_PackedValArr[m_SparseArr[static_cast<KeyType>(key)]]);
+				});
+		}
+
+	public:
+		//Write access that records the element as modified, only available with change tracking
+		Val& patch(KeyType element) noexcept requires change_tracker::enabled
+		{
+			ASSERT(contains(element), "Element not in set!");
+			m_Changes.on_modified(element);
+			return m_PackedValArr[m_SparseArr[element]];
+		}
+
+		//Records a write that went through operator[], an iterator or a parallel member
+		void mark_dirty(KeyType element) noexcept requires change_tracker::enabled
+		{
+			ASSERT(contains(element), "Element not in set!");
+			m_Changes.on_modified(element);
+		}
+
+		//Changes since the last consume_changes / clear_changes
+		const change_tracker& changes() const noexcept requires change_tracker::enabled { return m_Changes; }
+
+		//Calls func(key, change_kind) for every key with a net change since the last snapshot and starts a new one.
+		//Returns true when a sort, a sorted insert or an owning group changed the order of the remaining elements as well.
+		template<typename Func>
+		requires change_tracker::enabled && std::is_invocable_v<Func&, KeyType, change_kind>
+		bool consume_changes(Func&& func)
+		{
+			bool const reordered{ m_Changes.reordered() };
+			m_Changes.each(func);
+			m_Changes.clear();
+			return reordered;
+		}
+
+		void clear_changes() noexcept requires change_tracker::enabled
+		{
+			m_Changes.clear();
+		}
+
+	public:
+		//Event counts since the set was created or the last reset_stats, only available with collect_stats
+		[[nodiscard]] sparse_set_counters stats() const noexcept requires stats_recorder::enabled { return m_Stats.counters(); }
+
+		void reset_stats() noexcept requires stats_recorder::enabled
+		{
+			m_Stats.reset();
+		}
+
+		//Allocated against used bytes of every array, available with any stats policy.
+		//Sparse storages without a memory_usage member are estimated from their size.
+		[[nodiscard]] sparse_set_memory_usage memory_usage() const noexcept
+		{
+			sparse_set_memory_usage usage{ };
+			if constexpr (requires { m_SparseArr.memory_usage(); })
+			{
+				usage.sparseBytes = m_SparseArr.memory_usage();
+			}
+			else
+			{
+				usage.sparseBytes = m_SparseArr.size() * sizeof(dense_type);
+			}
+
+			usage.sparseSlots = m_SparseArr.size();
+			usage.denseBytes = m_DenseArr.size() * sizeof(KeyType);
+			usage.denseCapacityBytes = m_DenseArr.capacity() * sizeof(KeyType);
+			usage.packedBytes = m_PackedValArr.size() * sizeof(Val);
+			usage.packedCapacityBytes = m_PackedValArr.capacity() * sizeof(Val);
+			usage.sortBufferBytes = m_SortPerm.capacity() * sizeof(size_t) + m_SortKeys.capacity() * sizeof(uint64_t) + m_SortValues.capacity() * sizeof(Val);
+			usage.sparseOccupancy = usage.sparseSlots > 0 ? static_cast<double>(m_DenseArr.size()) / static_cast<double>(usage.sparseSlots) : 0.0;
+			return usage;
+		}
+
 	public:
 		void swap(sparse_set& other) noexcept
 		{
+			ASSERT(!m_Owner && !other.m_Owner, "Can not swap a set that is owned by a group!");
+
+			//Swapping containers with unequal allocators that do not propagate is undefined, those sets swap their elements through moves
+			if constexpr (!alloc_traits::propagate_on_container_swap::value && !alloc_traits::is_always_equal::value)
+			{
+				if (m_SparseArr.get_allocator() != other.m_SparseArr.get_allocator()
+					|| m_DenseArr.get_allocator() != other.m_DenseArr.get_allocator()
+					|| m_PackedValArr.get_allocator() != other.m_PackedValArr.get_allocator())
+				{
+					sparse_set temp{ std::move(other) };
+					other = std::move(*this);
+					*this = std::move(temp);
+					return;
+				}
+			}
+
 			std::swap(m_SparseArr, other.m_SparseArr);
-			std::swap(m_DenseArr, other.m_DenseArr);
-			std::swap(m_PackedValArr, other.m_PackedValArr);
+			m_DenseArr.swap(other.m_DenseArr);
+			m_PackedValArr.swap(other.m_PackedValArr);
+			std::swap(m_Changes, other.m_Changes);
+			std::swap(m_Stats, other.m_Stats);
+			reset_sort_buffers();
+			other.reset_sort_buffers();
 		}
 
 		//Should not swap elements that are not in the set, use try_swap if this is a concern
@@ -156,6 +509,9 @@ namespace Internal
 			ASSERT(el1 != el2, "Should not try swap element with itself!");
 			ASSERT(contains(el1) && contains(el2), "Set must contain elements!");
 			std::swap(m_DenseArr[m_SparseArr[el1]], m_DenseArr[m_SparseArr[el2]]);
+			m_Stats.on_swap();
+			m_Changes.on_modified(el1);
+			m_Changes.on_modified(el2);
 		}
 		bool try_swap_elements(KeyType el1, KeyType el2) noexcept
 		{
@@ -164,7 +520,10 @@ namespace Internal
 		//Should not swap elements that are not in the set, must use valid iterators
 		void swap_elements(const_iterator el1, const_iterator el2) noexcept
 		{
+			m_Changes.on_modified(m_DenseArr[val_index(el1)]);
+			m_Changes.on_modified(m_DenseArr[val_index(el2)]);
 			std::swap(m_DenseArr[val_index(el1)], m_DenseArr[val_index(el2)]);
+			m_Stats.on_swap();
 		}
 
 	public:
@@ -173,54 +532,257 @@ namespace Internal
 
 		[[nodiscard]] static constexpr KeyType max_sparse_size() noexcept
 		{
-			return INVALID_INDEX - 1;
+			return INVALID_KEY - 1;
+		}
+
+		//Largest amount of elements the dense index type can address
+		[[nodiscard]] static constexpr size_t max_size() noexcept
+		{
+			return INVALID_INDEX;
 		}
 
 		void resize(KeyType newSize, KeyType reserveSize = 0) noexcept
 		{
 			ASSERT(newSize > m_SparseArr.size(), "");
 
-			m_SparseArr.resize(newSize, INVALID_INDEX);
+			allocation_probe const before{ probe_allocations() };
+			m_SparseArr.resize(newSize);
 			m_DenseArr.reserve(reserveSize);
 			m_PackedValArr.reserve(reserveSize);
+			record_allocations(before);
 		}
 
 		void shrink_to_fit() noexcept
 		{
+			allocation_probe const before{ probe_allocations() };
 			m_SparseArr.shrink_to_fit();
 			m_DenseArr.shrink_to_fit();
 			m_PackedValArr.shrink_to_fit();
+			record_allocations(before);
+		}
+
+		//Drops the sparse entries behind the largest key and releases the unused sparse capacity, the dense arrays are left alone.
+		//Use a growth policy with a trim threshold (see basic_flat_sparse) to trim automatically.
+		void trim_sparse() noexcept
+		{
+			allocation_probe const before{ probe_allocations() };
+			m_SparseArr.shrink_to_fit();
+			record_allocations(before);
 		}
 
 		void sparse_reserve(KeyType newCap) noexcept
 		{
+			allocation_probe const before{ probe_allocations() };
 			m_SparseArr.reserve(newCap);
+			record_allocations(before);
 		}
 
 		void reserve(KeyType newCap) noexcept
 		{
+			allocation_probe const before{ probe_allocations() };
 			m_DenseArr.reserve(newCap);
 			m_PackedValArr.reserve(newCap);
+			record_allocations(before);
 		}
 
 		[[nodiscard]] bool empty() const noexcept { return m_DenseArr.empty(); }
 
 		void clear() noexcept
 		{
+			if constexpr (change_tracker::enabled)
+			{
+				for (KeyType const key : m_DenseArr)
+				{
+					m_Changes.on_removed(key);
+				}
+			}
+
+			allocation_probe const before{ probe_allocations() };
+			m_Stats.on_erase(m_DenseArr.size(), 0);
+
 			m_DenseArr.clear();
 			m_PackedValArr.clear();
 			m_SparseArr.clear();
+			record_allocations(before);
+
+			if (m_Owner)
+			{
+				m_Owner->on_clear();
+			}
+		}
+
+		//Returns true when an owning group keeps this set co-sorted with other sets
+		[[nodiscard]] bool owned() const noexcept { return m_Owner != nullptr; }
+
+		//Only available for the flat sparse policy, the other policies do not store one contiguous sparse array
+		const auto& sparse() const noexcept requires Impl::is_flat_sparse_v<SparsePolicy> { return m_SparseArr.data(); }
+		//Storage of any policy, e.g. to check which representation an adaptive set currently uses
+		const sparse_storage& get_sparse_storage() const noexcept { return m_SparseArr; }
+		//Bitset of the keys in the set, only available for the bitset_sparse policy
+		const auto& presence() const noexcept requires Impl::PresenceStorage<sparse_storage> { return m_SparseArr.presence(); }
+		const dense_container& dense() const noexcept { return m_DenseArr; }
+		const packed_container& data() const noexcept { return m_PackedValArr; }
+
+		//Allocator of the packed values
+		[[nodiscard]] allocator_type get_allocator() const noexcept { return m_PackedValArr.get_allocator(); }
+
+	public:
+		//Writes the set to a versioned, checksummed snapshot that stores the arrays as raw, 64 byte aligned blocks.
+		//Only the flat sparse policy stores its sparse array, the other policies rebuild theirs on load. See mapped_sparse_set.
+		void save(const std::filesystem::path& path) const requires std::is_trivially_copyable_v<Val>
+		{
+			Impl::snapshot_header header{ };
+			header.keySize = sizeof(KeyType);
+			header.denseSize = sizeof(dense_type);
+			header.valueSize = sizeof(Val);
+			header.valueAlign = alignof(Val);
+			header.count = m_DenseArr.size();
+
+			const void* sparse{ nullptr };
+			if constexpr (Impl::is_flat_sparse_v<SparsePolicy>)
+			{
+				sparse = m_SparseArr.data().data();
+				header.sparseCount = m_SparseArr.size();
+			}
+
+			Impl::write_snapshot(path, header, sparse, header.sparseCount * sizeof(dense_type),
+								 m_DenseArr.data(), m_DenseArr.size() * sizeof(KeyType), m_PackedValArr.data(), m_PackedValArr.size() * sizeof(Val));
 		}
 
-		const std::vector<KeyType>& sparse() const noexcept { return m_SparseArr; }
-		const std::vector<KeyType>& dense() const noexcept { return m_DenseArr; }
-		const std::vector<Val>& data() const noexcept { return m_PackedValArr; }
+		//Replaces the content of the set with a snapshot written by save, the blocks are read straight into the arrays.
+		//Throws sparse_set_snapshot_error when the file can not be read, is corrupted or was written for other types, the set is empty afterwards.
+		void load(const std::filesystem::path& path) requires std::is_trivially_copyable_v<Val> && std::is_default_constructible_v<Val>
+		{
+			ASSERT(!m_Owner, "Can not load into a set that is owned by a group!");
+
+			std::ifstream file{ path, std::ios::binary };
+			std::error_code error{ };
+			uint64_t const fileSize{ std::filesystem::file_size(path, error) };
+			if (!file || error)
+			{
+				throw sparse_set_snapshot_error{ "Can not open snapshot for reading", path };
+			}
+
+			Impl::snapshot_header header{ };
+			if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			{
+				throw sparse_set_snapshot_error{ "Snapshot is truncated", path };
+			}
+			Impl::validate_snapshot_header(header, fileSize, sizeof(KeyType), sizeof(dense_type), sizeof(Val), alignof(Val), path);
+			if (header.count > max_size())
+			{
+				throw sparse_set_snapshot_error{ "Snapshot holds more elements than the dense index type can address", path };
+			}
+
+			clear();
+
+			try
+			{
+				size_t const count{ static_cast<size_t>(header.count) };
+				m_DenseArr.resize(count);
+				m_PackedValArr.resize(count);
+				Impl::read_snapshot_block(file, header.denseOffset, m_DenseArr.data(), count * sizeof(KeyType), header.denseChecksum, path);
+				Impl::read_snapshot_block(file, header.valuesOffset, m_PackedValArr.data(), count * sizeof(Val), header.valuesChecksum, path);
+
+				bool rebuild{ true };
+				if constexpr (Impl::is_flat_sparse_v<SparsePolicy>)
+				{
+					if (header.sparseCount > 0)
+					{
+						auto& sparse{ m_SparseArr.data() };
+						sparse.resize(static_cast<size_t>(header.sparseCount));
+						Impl::read_snapshot_block(file, header.sparseOffset, sparse.data(), sparse.size() * sizeof(dense_type), header.sparseChecksum, path);
+						rebuild = false;
+					}
+				}
+
+				if (rebuild)
+				{
+					for (size_t i{ 0 }; i < count; ++i)
+					{
+						m_SparseArr.emplace(m_DenseArr[i], static_cast<dense_type>(i));
+					}
+				}
+			}
+			catch (...)
+			{
+				m_DenseArr.clear();
+				m_PackedValArr.clear();
+				m_SparseArr.clear();
+				throw;
+			}
+
+			notify_emplaced(0);
+		}
 
 	public:
 		[[nodiscard]] bool contains(KeyType element) const noexcept 
 		{ 
-			ASSERT(element != INVALID_INDEX, "Element must be a valid index!");
-			return element < m_SparseArr.size() && m_SparseArr[element] != INVALID_INDEX; 
+			ASSERT(element != INVALID_KEY, "Element must be a valid index!");
+
+			bool const found{ m_SparseArr.contains(element) };
+			if (!found)
+			{
+				m_Stats.on_lookup_miss();
+			}
+			return found;
+		}
+
+		//Writes the presence of every key as bit (i % 64) of mask[i / 64], mask must hold at least (keys.size() + 63) / 64 words.
+		//Gives the same result as calling contains for every key, returns the amount of keys in the set.
+		size_t contains_many(std::span<const KeyType> keys, std::span<uint64_t> mask) const noexcept
+		{
+			ASSERT(mask.size() * 64 >= keys.size(), "Mask too small for the keys!");
+
+			std::array<dense_type, 64> indices;
+			size_t count{ 0 };
+
+			for (size_t block{ 0 }; block * 64 < keys.size(); ++block)
+			{
+				size_t const blockSize{ std::min<size_t>(64, keys.size() - block * 64) };
+				m_SparseArr.get_many(keys.data() + block * 64, blockSize, indices.data());
+
+				uint64_t word{ 0 };
+				for (size_t i{ 0 }; i < blockSize; ++i)
+				{
+					word |= static_cast<uint64_t>(indices[i] != INVALID_INDEX) << i;
+				}
+
+				mask[block] = word;
+				count += static_cast<size_t>(std::popcount(word));
+			}
+
+			m_Stats.on_lookup_miss(keys.size() - count);
+			return count;
+		}
+
+		//Writes the dense index of every key, INVALID_INDEX for keys that are not in the set. Returns the amount of keys in the set.
+		size_t get_many(std::span<const KeyType> keys, std::span<dense_type> indices) const noexcept
+		{
+			ASSERT(indices.size() >= keys.size(), "Output too small for the keys!");
+
+			m_SparseArr.get_many(keys.data(), keys.size(), indices.data());
+			size_t const count{ static_cast<size_t>(std::count_if(indices.begin(), indices.begin() + keys.size(), [](dense_type index) { return index != INVALID_INDEX; })) };
+
+			m_Stats.on_lookup_miss(keys.size() - count);
+			return count;
+		}
+
+		//Writes a pointer to the value of every key, nullptr for keys that are not in the set. Returns the amount of keys in the set.
+		size_t get_many(std::span<const KeyType> keys, std::span<Val*> values) noexcept
+		{
+			return gather_values(keys, values.data(), m_PackedValArr.data());
+		}
+		size_t get_many(std::span<const KeyType> keys, std::span<Val const*> values) const noexcept
+		{
+			return gather_values(keys, values.data(), m_PackedValArr.data());
+		}
+
+		//Element must exist to get a valid value
+		[[nodiscard]] dense_type index(KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_SparseArr[element];
 		}
 
 		//Iterator must be in bounds to get a valid value
@@ -284,37 +846,46 @@ namespace Internal
 		requires std::is_constructible_v<Val, Args...>
 		Val& emplace(KeyType element, Args&&... args) noexcept
 		{
-			ASSERT(!contains(element), "Element already in set!");
+			ASSERT(!m_SparseArr.contains(element), "Element already in set!");
+
+			ASSERT(m_DenseArr.size() < max_size(), "Dense index type is full!");
+			allocation_probe const before{ probe_allocations() };
+			m_SparseArr.emplace(element, static_cast<dense_type>(m_DenseArr.size()));
+
+			m_DenseArr.emplace_back(element);
+			Val& value{ m_PackedValArr.emplace_back(std::forward<Args>(args)...) };
+			m_Changes.on_added(element);
+			m_Stats.on_emplace(1);
+			record_allocations(before);
 
-			if (element >= m_SparseArr.size())
+			if (m_Owner)
 			{
-				m_SparseArr.resize(element + 1, INVALID_INDEX);
+				//The group may have moved the element to the front
+				m_Owner->on_emplace(element);
+				return m_PackedValArr[m_SparseArr[element]];
 			}
 
-			m_SparseArr[element] = static_cast<KeyType>(m_DenseArr.size());
-
-			m_DenseArr.emplace_back(element);
-			return m_PackedValArr.emplace_back(std::forward<Args>(args)...);
+			return value;
 		}
 
 		template<typename... Args>
 		requires std::is_constructible_v<Val, Args...>
 		std::pair<iterator, bool> try_emplace(KeyType element, Args&&... args) noexcept
 		{
-			if (contains(element))
+			if (m_SparseArr.contains(element))
 			{
 				return { m_PackedValArr.begin() + m_SparseArr[element], false};
 			}
 			
 			emplace(element, std::forward<Args>(args)...);
-			return { iterator{ m_PackedValArr.end() - 1 }, true };
+			return { m_PackedValArr.begin() + m_SparseArr[element], true };
 		}
 
 		template<typename... Args>
 		requires std::is_constructible_v<Val, Args...>
 		Val& get_or_emplace(KeyType element, Args&&... args) noexcept
 		{
-			if (!contains(element))
+			if (!m_SparseArr.contains(element))
 			{
 				return emplace(element, std::forward<Args>(args)...);
 			}
@@ -322,33 +893,99 @@ namespace Internal
 			return m_PackedValArr[m_SparseArr[element]];
 		}
 
-	public:
-		//Do not erase an element that does not exist, use remove instead if this is a concern.
-		void erase(KeyType element) noexcept
+		//Emplaces all keys with their matching value in one pass, values are moved out of the span.
+		//Do not emplace elements that are already in the set or duplicate keys, use try_emplace_bulk if this is a concern.
+		void emplace_bulk(std::span<const KeyType> keys, std::span<Val> values) noexcept
 		{
-			ASSERT(contains(element), "Element not in set!");
+			ASSERT(keys.size() == values.size(), "Every key needs a value!");
+			allocation_probe const before{ probe_allocations() };
+			bulk_prepare(keys);
 
-			if constexpr (std::is_trivially_copyable_v<Val>)
+			dense_type index{ static_cast<dense_type>(m_DenseArr.size()) };
+			for (KeyType const key : keys)
+			{
+				ASSERT(!m_SparseArr.contains(key), "Element already in set!");
+				m_SparseArr.emplace(key, index++);
+			}
+
+			m_DenseArr.insert(m_DenseArr.end(), keys.begin(), keys.end());
+			bulk_append(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+
+			record_allocations(before);
+			notify_emplaced(m_DenseArr.size() - keys.size());
+		}
+
+		//Inserts copies of all values in one pass.
+		//Do not insert elements that are already in the set or duplicate keys, use try_emplace_bulk if this is a concern.
+		void insert_range(std::span<const KeyType> keys, std::span<const Val> values) noexcept
+		requires std::is_copy_constructible_v<Val>
+		{
+			ASSERT(keys.size() == values.size(), "Every key needs a value!");
+			allocation_probe const before{ probe_allocations() };
+			bulk_prepare(keys);
+
+			dense_type index{ static_cast<dense_type>(m_DenseArr.size()) };
+			for (KeyType const key : keys)
 			{
-				std::memcpy(&m_PackedValArr[m_SparseArr[element]], &m_PackedValArr.back(), sizeof(Val));
+				ASSERT(!m_SparseArr.contains(key), "Element already in set!");
+				m_SparseArr.emplace(key, index++);
 			}
-			else if constexpr(Impl::MoveAssignmentVal<Val>)
+
+			m_DenseArr.insert(m_DenseArr.end(), keys.begin(), keys.end());
+			bulk_append(values.begin(), values.end());
+
+			record_allocations(before);
+			notify_emplaced(m_DenseArr.size() - keys.size());
+		}
+
+		//Emplaces the keys that are not in the set yet, keys already in the set (or earlier in the batch) are skipped and their values left untouched.
+		//Returns the amount of emplaced elements.
+		size_t try_emplace_bulk(std::span<const KeyType> keys, std::span<Val> values) noexcept
+		{
+			ASSERT(keys.size() == values.size(), "Every key needs a value!");
+			allocation_probe const before{ probe_allocations() };
+			bulk_prepare(keys);
+
+			size_t const oldSize{ m_DenseArr.size() };
+			for (size_t i{ 0 }; i < keys.size(); ++i)
 			{
-				m_PackedValArr[m_SparseArr[element]] = std::move(m_PackedValArr.back());
+				if (!m_SparseArr.contains(keys[i]))
+				{
+					m_SparseArr.emplace(keys[i], static_cast<dense_type>(m_DenseArr.size()));
+					m_DenseArr.emplace_back(keys[i]);
+					m_PackedValArr.emplace_back(std::move(values[i]));
+				}
 			}
-			else if constexpr(Impl::MoveConstructVal<Val>)
+
+			record_allocations(before);
+			notify_emplaced(oldSize);
+			return m_DenseArr.size() - oldSize;
+		}
+
+	public:
+		//Do not erase an element that does not exist, use remove instead if this is a concern.
+		void erase(KeyType element) noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+
+			if (m_Owner)
 			{
-				m_PackedValArr[m_SparseArr[element]].~Val();
-				new (&m_PackedValArr[m_SparseArr[element]]) Val(std::move(m_PackedValArr.back()));
+				m_Owner->on_erase(element);
 			}
+			m_Changes.on_removed(element);
+			m_Stats.on_erase(1, m_SparseArr[element] != m_DenseArr.size() - 1 ? 1 : 0);
+			allocation_probe const before{ probe_allocations() };
+
+			move_value(m_SparseArr[element], m_DenseArr.size() - 1);
 			
 			m_DenseArr[m_SparseArr[element]] = m_DenseArr.back();
 			
 			m_SparseArr[m_DenseArr.back()] = m_SparseArr[element];
-			m_SparseArr[element] = INVALID_INDEX;
+			m_SparseArr.release(element);
 
 			m_DenseArr.pop_back();
 			m_PackedValArr.pop_back();
+			record_allocations(before);
 		}
 
 		//Do not erase with iterator that's out of bounds
@@ -368,13 +1005,38 @@ namespace Internal
 			ASSERT(!(last > cend() || first < cbegin()) && first < last, "Iterator out of bounds!");
 			ASSERT(first != last, "First == last erases nothing!");
 
-			--last;
-			while (last > first)
+			size_t const firstIdx{ static_cast<size_t>(first - cbegin()) };
+			size_t const lastIdx{ static_cast<size_t>(last - cbegin()) };
+
+			if (m_Owner)
+			{
+				//Erasing back to front only moves elements behind the current position, so the range keeps its elements
+				for (size_t i{ lastIdx }; i > firstIdx; --i)
+				{
+					erase(m_DenseArr[i - 1]);
+				}
+				return begin() + firstIdx;
+			}
+
+			size_t const newSize{ m_DenseArr.size() - (lastIdx - firstIdx) };
+			m_Stats.on_erase(lastIdx - firstIdx, std::min(lastIdx, newSize) - std::min(firstIdx, newSize));
+			allocation_probe const before{ probe_allocations() };
+
+			for (size_t i{ firstIdx }; i < lastIdx; ++i)
+			{
+				m_Changes.on_removed(m_DenseArr[i]);
+				m_SparseArr.release(m_DenseArr[i]);
+			}
+
+			//Fill the holes that stay inside the new size with the elements behind the range
+			for (size_t hole{ firstIdx }, src{ std::max(lastIdx, newSize) }; hole < std::min(lastIdx, newSize); ++hole, ++src)
 			{
-				last = --erase(last);
+				relocate(hole, src);
 			}
 
-			return erase(last);
+			truncate(newSize);
+			record_allocations(before);
+			return begin() + firstIdx;
 		}
 
 		bool remove(KeyType element) noexcept
@@ -382,95 +1044,243 @@ namespace Internal
 			return contains(element) && (erase(element), true);
 		}
 
-	public:
-		template <Impl::Compare<Val> Compare = std::less< >>
-		void sort(Compare&& compare = { })
+		//Erases all elements in the batch in one compaction pass, keys that are not in the set are ignored.
+		//Returns the amount of erased elements.
+		size_t erase_many(std::span<const KeyType> keys) noexcept
 		{
-			std::vector<size_t> copy(m_PackedValArr.size());
-			std::iota(copy.begin(), copy.end(), size_t{ });
-
-			std::sort(copy.begin(), copy.end(),
-				[this, compare{ std::forward<Compare>(compare) }](const auto lhs, const auto rhs)
+			if (m_Owner)
+			{
+				//Moves every element of the batch out of the group, the compaction below never touches the group again
+				for (KeyType const key : keys)
 				{
-					return std::invoke(compare, m_PackedValArr[lhs], m_PackedValArr[rhs]);
-				});
+					if (m_SparseArr.contains(key))
+					{
+						m_Owner->on_erase(key);
+					}
+				}
+			}
 
-			for (size_t pos{ 0 }; pos < copy.size(); ++pos) 
+			//Tag the dense slot of every element in the batch, duplicate keys are only counted once
+			size_t count{ 0 };
+			for (KeyType const key : keys)
 			{
-				size_t curr = pos;
-				size_t next = copy[curr];
-				
-				while (curr != next) 
+				if (m_SparseArr.contains(key) && m_DenseArr[m_SparseArr[key]] != INVALID_KEY)
 				{
-					swap_values(m_DenseArr[copy[curr]], m_DenseArr[copy[next]]);
-					std::swap(m_SparseArr[m_DenseArr[copy[curr]]], m_SparseArr[m_DenseArr[copy[next]]]);
-
-					std::swap(m_DenseArr[copy[curr]], m_DenseArr[copy[next]]);
-
-					copy[curr] = curr;
-					curr = next;
-					next = copy[curr];
+					m_DenseArr[m_SparseArr[key]] = INVALID_KEY;
+					++count;
 				}
 			}
-		}
 
-		//Slower sort function without the copy, should be possibly to make faster  - TODO
-		//template<typename Compare>
-		//void sort(Compare compare)
-		//{
-		//	[The bottleneck is the actual sort here, likely due to the extra indirection.]
-		//	std::sort(m_DenseArr.begin(), m_DenseArr.end(), std::move(compare));
+			//Holes below the new size are filled with the untagged elements from the back
+			size_t const newSize{ m_DenseArr.size() - count };
+			size_t tail{ m_DenseArr.size() };
+			size_t moved{ 0 };
+			allocation_probe const before{ probe_allocations() };
+
+			for (KeyType const key : keys)
+			{
+				if (!m_SparseArr.contains(key))
+				{
+					continue;
+				}
 
-		//	for (KeyType pos{ 0 }; pos < m_PackedValArr.size(); ++pos)
-		//	{
-		//		KeyType curr = pos;
-		//		auto next = m_SparseArr[m_DenseArr[curr]];
+				size_t const hole{ m_SparseArr[key] };
+				m_Changes.on_removed(key);
+				m_SparseArr.release(key);
 
-		//		while (curr != next)
-		//		{
-		//			swap_values(m_DenseArr[curr], m_DenseArr[next]);
-		//			m_SparseArr[m_DenseArr[curr]] = curr;
+				if (hole < newSize)
+				{
+					do
+					{
+						--tail;
+					} while (m_DenseArr[tail] == INVALID_KEY);
 
-		//			curr = next;
-		//			next = m_SparseArr[m_DenseArr[curr]];
-		//		}
-		//	}
-		//}
+					relocate(hole, tail);
+					++moved;
+				}
+			}
 
-		template <Impl::Compare<Val> Compare = std::less< >>
-		[[nodiscard]] bool is_sorted(Compare&& compare = { }) const noexcept
-		{
-			return std::is_sorted(m_PackedValArr.begin(), m_PackedValArr.end(), std::forward<Compare>(compare));
+			truncate(newSize);
+			m_Stats.on_erase(count, moved);
+			record_allocations(before);
+			return count;
 		}
 
-		//Emplace element in a sorted set, set should be sorted before using && element should not be in set yet.
-		template<typename... Args, Impl::Compare<Val> Compare>
-		requires std::is_constructible_v<Val, Args...> && Impl::MoveAssignmentVal<Val>
-		iterator emplace_sorted(KeyType element, Compare&& compare, Args&&... args) noexcept
+		//Erases all elements the predicate returns true for in one compaction pass, the order of the remaining elements is kept.
+		//The predicate is called with either (const Val&) or (KeyType, const Val&). Returns the amount of erased elements.
+		template<typename Pred>
+		requires std::is_invocable_r_v<bool, Pred&, Val const&> || std::is_invocable_r_v<bool, Pred&, KeyType, Val const&>
+		size_t erase_if(Pred pred) noexcept
 		{
-			DEBUG_ASSERT(is_sorted(std::forward<Compare>(compare)), "Set must be sorted");
-			ASSERT(!contains(element), "Element already in set!");
-
-			if (element >= m_SparseArr.size())
+			if (m_Owner)
 			{
-				m_SparseArr.resize(element + 1, INVALID_INDEX);
-			}
+				//Erasing back to front only moves already visited elements
+				size_t const oldSize{ m_DenseArr.size() };
+				for (size_t i{ oldSize }; i > 0; --i)
+				{
+					bool erased;
+					if constexpr (std::is_invocable_r_v<bool, Pred&, KeyType, Val const&>)
+					{
+						erased = std::invoke(pred, m_DenseArr[i - 1], std::as_const(m_PackedValArr[i - 1]));
+					}
+					else
+					{
+						erased = std::invoke(pred, std::as_const(m_PackedValArr[i - 1]));
+					}
+
+					if (erased)
+					{
+						erase(m_DenseArr[i - 1]);
+					}
+				}
+				return oldSize - m_DenseArr.size();
+			}
+
+			size_t write{ 0 };
+			size_t moved{ 0 };
+			allocation_probe const before{ probe_allocations() };
+			for (size_t read{ 0 }; read < m_DenseArr.size(); ++read)
+			{
+				bool erased;
+				if constexpr (std::is_invocable_r_v<bool, Pred&, KeyType, Val const&>)
+				{
+					erased = std::invoke(pred, m_DenseArr[read], std::as_const(m_PackedValArr[read]));
+				}
+				else
+				{
+					erased = std::invoke(pred, std::as_const(m_PackedValArr[read]));
+				}
+
+				if (erased)
+				{
+					m_Changes.on_removed(m_DenseArr[read]);
+					m_SparseArr.release(m_DenseArr[read]);
+					continue;
+				}
+
+				if (write != read)
+				{
+					relocate(write, read);
+					++moved;
+				}
+				++write;
+			}
+
+			size_t const count{ m_DenseArr.size() - write };
+			truncate(write);
+			m_Stats.on_erase(count, moved);
+			record_allocations(before);
+			return count;
+		}
+
+	public:
+		//Sorts the values, integral values sorted with the default compare use the radix sort path.
+		template <Impl::Compare<Val> Compare = std::less< >>
+		void sort(Compare&& compare = { })
+		{
+			ASSERT(!m_Owner, "Can not sort a set that is owned by a group!");
+			m_Changes.on_reordered();
+
+			if constexpr (Impl::RadixKey<Val> && (std::is_same_v<std::remove_cvref_t<Compare>, std::less<>> 
+												|| std::is_same_v<std::remove_cvref_t<Compare>, std::less<Val>>))
+			{
+				radix_sort([this](size_t i) { return m_PackedValArr[i]; });
+			}
+			else
+			{
+				auto& perm{ m_SortPerm };
+				perm.resize(m_PackedValArr.size());
+				std::iota(perm.begin(), perm.end(), size_t{ });
+
+				std::sort(perm.begin(), perm.end(),
+					[this, &compare](const auto lhs, const auto rhs)
+					{
+						return std::invoke(compare, m_PackedValArr[lhs], m_PackedValArr[rhs]);
+					});
+
+				apply_permutation(perm.data());
+			}
+		}
+
+		//Sorts the values by the projection, projections returning an integral key use the radix sort path.
+		template <typename Projection>
+		requires std::is_invocable_v<Projection&, Val const&>
+		void sort_by(Projection&& projection)
+		{
+			ASSERT(!m_Owner, "Can not sort a set that is owned by a group!");
+			m_Changes.on_reordered();
+
+			using ProjectedType = std::remove_cvref_t<std::invoke_result_t<Projection&, Val const&>>;
+			if constexpr (Impl::RadixKey<ProjectedType>)
+			{
+				radix_sort([this, &projection](size_t i) { return std::invoke(projection, std::as_const(m_PackedValArr[i])); });
+			}
+			else
+			{
+				sort([&projection](Val const& lhs, Val const& rhs) { return std::invoke(projection, lhs) < std::invoke(projection, rhs); });
+			}
+		}
+
+		//Orders the values by their key, after sorting dense() is ascending.
+		void sort_by_key()
+		{
+			ASSERT(!m_Owner, "Can not sort a set that is owned by a group!");
+			m_Changes.on_reordered();
+			radix_sort([this](size_t i) { return m_DenseArr[i]; });
+		}
+
+		//Parallel comparison sort on the executor (the built-in pool by default), one run per executor thread.
+		//Sorts the index permutation in runs that are merged pairwise, then gathers the keys and values into double buffers 
+		//and fixes up the sparse storage, each pass split over the executor.
+		template <Impl::Executor Executor, Impl::Compare<Val> Compare = std::less< >>
+		void parallel_sort(Executor& executor, Compare&& compare = { })
+		{
+			ASSERT(!m_Owner, "Can not sort a set that is owned by a group!");
+			m_Changes.on_reordered();
+			sort_on(executor, compare);
+		}
+		template <Impl::Compare<Val> Compare = std::less< >>
+		void parallel_sort(Compare&& compare = { })
+		{
+			parallel_sort(default_thread_pool(), std::forward<Compare>(compare));
+		}
+
+		template <Impl::Compare<Val> Compare = std::less< >>
+		[[nodiscard]] bool is_sorted(Compare&& compare = { }) const noexcept
+		{
+			return std::is_sorted(m_PackedValArr.begin(), m_PackedValArr.end(), std::forward<Compare>(compare));
+		}
+
+		//Emplace element in a sorted set, set should be sorted before using && element should not be in set yet.
+		template<typename... Args, Impl::Compare<Val> Compare>
+		requires std::is_constructible_v<Val, Args...> && Impl::MoveAssignmentVal<Val>
+		iterator emplace_sorted(KeyType element, Compare&& compare, Args&&... args) noexcept
+		{
+			DEBUG_ASSERT(is_sorted(std::forward<Compare>(compare)), "Set must be sorted");
+			ASSERT(!m_SparseArr.contains(element), "Element already in set!");
+			ASSERT(!m_Owner, "Can not emplace sorted in a set that is owned by a group!");
 
 			Val const value{ std::forward<Args>(args)... };
+			allocation_probe const before{ probe_allocations() };
 
 			auto const insertIt = lower_bound(value, std::forward<Compare>(compare));
-			KeyType const denseIndex = static_cast<KeyType>(std::distance(m_PackedValArr.begin(), insertIt));
+			dense_type const denseIndex = static_cast<dense_type>(std::distance(m_PackedValArr.begin(), insertIt));
 
 			m_DenseArr.insert(m_DenseArr.begin() + denseIndex, element);
-			m_SparseArr[element] = denseIndex;
+			m_SparseArr.emplace(element, denseIndex);
+			m_Changes.on_added(element);
+			m_Changes.on_reordered();
 
 			m_PackedValArr.insert(insertIt, std::move(value));
 
-			for (KeyType i = denseIndex + 1; i < m_DenseArr.size(); ++i)
+			for (size_t i = denseIndex + size_t{ 1 }; i < m_DenseArr.size(); ++i)
 			{
-				m_SparseArr[m_DenseArr[i]] = i;
+				m_SparseArr[m_DenseArr[i]] = static_cast<dense_type>(i);
 			}
 
+			m_Stats.on_emplace(1);
+			m_Stats.on_sorted_insert(m_DenseArr.size() - denseIndex - 1);
+			record_allocations(before);
 			return m_PackedValArr.begin() + denseIndex;
 		}
 		//Emplace element in a sorted set, set should be sorted before using && element should not be in set yet.
@@ -486,7 +1296,7 @@ namespace Internal
 		requires std::is_constructible_v<Val, Args...>&& Impl::MoveAssignmentVal<Val>
 		std::pair<iterator, bool> try_emplace_sorted(KeyType element, Compare&& compare, Args&&... args) noexcept
 		{
-			if (contains(element))
+			if (m_SparseArr.contains(element))
 			{
 				return { m_PackedValArr.begin() + m_SparseArr[element], false };
 			}
@@ -500,29 +1310,215 @@ namespace Internal
 			return try_emplace_sorted(element, std::less<>{ }, std::forward<Args>(args)...);
 		}
 
+		//Inserts a batch in a sorted set in O(n + k log k), set should be sorted && keys should not be in set yet, values are moved out of the span.
+		//Sorts the batch, merges it into the packed values from the back in one pass and only touches the sparse entries of moved elements.
+		//New values are placed in front of equal values that are already in the set, like emplace_sorted.
+		template<Impl::Compare<Val> Compare = std::less< >>
+		void insert_sorted_range(std::span<const KeyType> keys, std::span<Val> values, Compare&& compare = { }) noexcept
+		{
+			ASSERT(keys.size() == values.size(), "Every key needs a value!");
+			ASSERT(!m_Owner, "Can not emplace sorted in a set that is owned by a group!");
+			DEBUG_ASSERT(is_sorted(compare), "Set must be sorted");
+
+			if (keys.empty())
+			{
+				return;
+			}
+
+			allocation_probe const before{ probe_allocations() };
+			bulk_prepare(keys);
+
+			size_t const oldSize{ m_DenseArr.size() };
+			size_t const count{ keys.size() };
+
+			auto& perm{ m_SortPerm };
+			perm.resize(count);
+			std::iota(perm.begin(), perm.end(), size_t{ });
+			std::stable_sort(perm.begin(), perm.end(),
+				[&values, &compare](const auto lhs, const auto rhs)
+				{
+					return std::invoke(compare, values[lhs], values[rhs]);
+				});
+
+			//Appends the sorted batch, then moves it aside into the scratch buffers so the merge can write the tail slots
+			m_SortKeys.resize(count);
+			m_SortValues.reserve(count);
+			m_DenseArr.resize(oldSize + count);
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				ASSERT(!m_SparseArr.contains(keys[perm[i]]), "Element already in set!");
+				m_SortKeys[i] = keys[perm[i]];
+				m_PackedValArr.emplace_back(std::move(values[perm[i]]));
+				m_SortValues.emplace_back(std::move(m_PackedValArr.back()));
+			}
+
+			//Backward merge, the elements in front of the first batch value are never touched
+			size_t existing{ oldSize };
+			size_t batch{ count };
+			for (size_t write{ oldSize + count }; batch > 0; --write)
+			{
+				if (existing > 0 && !std::invoke(compare, m_PackedValArr[existing - 1], m_SortValues[batch - 1]))
+				{
+					relocate(write - 1, existing - 1);
+					--existing;
+				}
+				else
+				{
+					Impl::assign_value(m_PackedValArr[write - 1], std::move(m_SortValues[batch - 1]));
+					m_DenseArr[write - 1] = static_cast<KeyType>(m_SortKeys[batch - 1]);
+					m_SparseArr.emplace(m_DenseArr[write - 1], static_cast<dense_type>(write - 1));
+					m_Changes.on_added(m_DenseArr[write - 1]);
+					--batch;
+				}
+			}
+
+			m_SortValues.clear();
+			if (existing != oldSize)
+			{
+				m_Changes.on_reordered();
+			}
+
+			m_Stats.on_emplace(count);
+			m_Stats.on_sorted_insert(oldSize - existing);
+			record_allocations(before);
+		}
+
+	public:
+		//Calls func(Val&) for every value, split in cache line aligned chunks over the executor (the built-in pool by default).
+		//func may run concurrently for different values, the set must not be resized until the call returns.
+		template<Impl::Executor Executor, typename Func>
+		requires std::is_invocable_v<Func&, Val&>
+		void parallel_for_each(Executor& executor, Func&& func)
+		{
+			parallel_chunks(executor, [this, &func](size_t first, size_t last)
+				{
+					for (size_t i{ first }; i < last; ++i)
+					{
+						std::invoke(func, m_PackedValArr[i]);
+					}
+				});
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, Val&>
+		void parallel_for_each(Func&& func)
+		{
+			parallel_for_each(default_thread_pool(), std::forward<Func>(func));
+		}
+
+		//Calls func(key, Val&) for every element, split in cache line aligned chunks over the executor (the built-in pool by default).
+		template<Impl::Executor Executor, typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void parallel_each(Executor& executor, Func&& func)
+		{
+			parallel_chunks(executor, [this, &func](size_t first, size_t last)
+				{
+					for (size_t i{ first }; i < last; ++i)
+					{
+						std::invoke(func, m_DenseArr[i], m_PackedValArr[i]);
+					}
+				});
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void parallel_each(Func&& func)
+		{
+			parallel_each(default_thread_pool(), std::forward<Func>(func));
+		}
+
+		//Maps every element with map(Val const&) or map(key, Val const&) and folds the results with reduce, starting from init.
+		//The dense range is cut in fixed size blocks that are folded in dense order, the result does not depend on the executor
+		//or the scheduling, so non associative reductions (e.g. floating point sums) are reproducible.
+		template<Impl::Executor Executor, typename T, typename Map, typename Reduce>
+		[[nodiscard]] T parallel_reduce(Executor& executor, T init, Map&& map, Reduce&& reduce) const
+		{
+			auto const mapAt = [this, &map](size_t i) -> T
+				{
+					if constexpr (std::is_invocable_v<Map&, KeyType, Val const&>)
+					{
+						return std::invoke(map, m_DenseArr[i], m_PackedValArr[i]);
+					}
+					else
+					{
+						return std::invoke(map, m_PackedValArr[i]);
+					}
+				};
+
+			//Padded so neighbouring partial results never share a cache line
+			struct partial final
+			{
+				std::optional<T> value{ };
+				std::byte padding[Impl::CACHE_LINE_SIZE]{ };
+			};
+
+			size_t const count{ m_PackedValArr.size() };
+			size_t const blockCount{ (count + REDUCE_BLOCK_SIZE - 1) / REDUCE_BLOCK_SIZE };
+			std::vector<partial> partials(blockCount);
+
+			size_t const taskCount{ std::min(blockCount, executor_width(executor) * PARALLEL_TASKS_PER_THREAD) };
+			Impl::run_chunks(executor, taskCount, [&](size_t task)
+				{
+					for (size_t block{ task * blockCount / taskCount }; block < (task + 1) * blockCount / taskCount; ++block)
+					{
+						size_t const last{ std::min(count, (block + 1) * REDUCE_BLOCK_SIZE) };
+
+						T acc{ mapAt(block * REDUCE_BLOCK_SIZE) };
+						for (size_t i{ block * REDUCE_BLOCK_SIZE + 1 }; i < last; ++i)
+						{
+							acc = std::invoke(reduce, std::move(acc), mapAt(i));
+						}
+						partials[block].value.emplace(std::move(acc));
+					}
+				});
+
+			for (partial& block : partials)
+			{
+				init = std::invoke(reduce, std::move(init), std::move(*block.value));
+			}
+			return init;
+		}
+		template<typename T, typename Map, typename Reduce>
+		[[nodiscard]] T parallel_reduce(T init, Map&& map, Reduce&& reduce) const
+		{
+			return parallel_reduce(default_thread_pool(), std::move(init), std::forward<Map>(map), std::forward<Reduce>(reduce));
+		}
+
 	private:
-		static constexpr KeyType INVALID_INDEX = std::numeric_limits<KeyType>::max();
+		static constexpr KeyType INVALID_KEY = std::numeric_limits<KeyType>::max();
+		static constexpr dense_type INVALID_INDEX = std::numeric_limits<dense_type>::max();
 
-		std::vector<KeyType> m_SparseArr{ };
+		sparse_storage m_SparseArr{ };
 
-		std::vector<KeyType> m_DenseArr{ };
-		std::vector<Val> m_PackedValArr{ };
+		dense_container m_DenseArr{ };
+		packed_container m_PackedValArr{ };
+
+		//Reused between sorts so sorting does not allocate once the buffers are large enough, they use the packed allocator
+		std::vector<size_t, rebind_alloc<size_t>> m_SortPerm{ };
+		std::vector<uint64_t, rebind_alloc<uint64_t>> m_SortKeys{ };
+		packed_container m_SortValues{ };
+
+		Impl::sparse_set_owner<KeyType>* m_Owner{ nullptr };
+
+		SPARSE_SET_NO_UNIQUE_ADDRESS change_tracker m_Changes{ };
+		SPARSE_SET_NO_UNIQUE_ADDRESS stats_recorder m_Stats{ };
+
+		template<typename... Sets>
+		friend class owning_group;
 
 	private:
 		template <typename IteratorType>
-		inline [[nodiscard]] KeyType val_index(IteratorType pos) const noexcept
+		[[nodiscard]] inline dense_type val_index(IteratorType pos) const noexcept
 		{
 			if constexpr (std::is_same_v<IteratorType, reverse_iterator>
 				|| std::is_same_v<IteratorType, const_reserve_iterator>)
 			{
 				ASSERT(!(pos >= rend() && pos < rbegin()), "Reverse iterator out of bounds");
-				return static_cast<KeyType>(rend() - 1 - pos);
+				return static_cast<dense_type>(rend() - 1 - pos);
 			}
 			else if constexpr (std::is_same_v<IteratorType, iterator>
 					|| std::is_same_v<IteratorType, const_iterator>)
 			{
 				ASSERT(!(pos >= end() && pos < begin()), "Iterator out of bounds");
-				return static_cast<KeyType>(pos - begin());
+				return static_cast<dense_type>(pos - begin());
 			}
 		}
 
@@ -563,6 +1559,426 @@ namespace Internal
 			swap_values(sparse_index(el1), sparse_index(el2));
 		}
 	
+	private:
+		//Swaps two elements by their dense index, keeping the sparse storage up to date
+		void swap_at(size_t lhs, size_t rhs) noexcept
+		{
+			if (lhs == rhs)
+			{
+				return;
+			}
+
+			KeyType const lhsKey{ m_DenseArr[lhs] };
+			KeyType const rhsKey{ m_DenseArr[rhs] };
+			m_Changes.on_reordered();
+			m_Stats.on_swap();
+
+			swap_values(lhsKey, rhsKey);
+			std::swap(m_DenseArr[lhs], m_DenseArr[rhs]);
+			std::swap(m_SparseArr[lhsKey], m_SparseArr[rhsKey]);
+		}
+
+		void notify_emplaced(size_t first) noexcept
+		{
+			m_Stats.on_emplace(m_DenseArr.size() - first);
+
+			if constexpr (change_tracker::enabled)
+			{
+				for (size_t i{ first }; i < m_DenseArr.size(); ++i)
+				{
+					m_Changes.on_added(m_DenseArr[i]);
+				}
+			}
+
+			if (m_Owner)
+			{
+				//The owner only swaps the current element with an already visited one
+				for (size_t i{ first }; i < m_DenseArr.size(); ++i)
+				{
+					m_Owner->on_emplace(m_DenseArr[i]);
+				}
+			}
+		}
+
+		template<typename Ptr>
+		size_t gather_values(std::span<const KeyType> keys, Ptr* values, Ptr base) const noexcept
+		{
+			std::array<dense_type, 64> indices;
+			size_t count{ 0 };
+
+			for (size_t offset{ 0 }; offset < keys.size(); offset += 64)
+			{
+				size_t const blockSize{ std::min<size_t>(64, keys.size() - offset) };
+				m_SparseArr.get_many(keys.data() + offset, blockSize, indices.data());
+
+				for (size_t i{ 0 }; i < blockSize; ++i)
+				{
+					bool const found{ indices[i] != INVALID_INDEX };
+					values[offset + i] = found ? base + indices[i] : nullptr;
+					count += found;
+				}
+			}
+
+			m_Stats.on_lookup_miss(keys.size() - count);
+			return count;
+		}
+
+	private:
+		//Drops the sort buffers so they allocate from the current packed allocator again
+		void reset_sort_buffers() noexcept
+		{
+			m_SortPerm = decltype(m_SortPerm)(rebind_alloc<size_t>{ m_PackedValArr.get_allocator() });
+			m_SortKeys = decltype(m_SortKeys)(rebind_alloc<uint64_t>{ m_PackedValArr.get_allocator() });
+			m_SortValues = packed_container(m_PackedValArr.get_allocator());
+		}
+
+		//Moves the value at dense index src into dense index dst, overwriting the value at dst
+		void move_value(size_t dst, size_t src) noexcept
+		{
+			if (dst != src)
+			{
+				Impl::assign_value(m_PackedValArr[dst], std::move(m_PackedValArr[src]));
+			}
+		}
+
+		//Reorders the elements so that the new element i is the old element perm[i], perm is consumed.
+		//Values and keys are moved along the cycles of the permutation, the sparse storage is fixed up in one linear pass afterwards.
+		void apply_permutation(size_t* perm) noexcept
+		{
+			size_t const count{ m_DenseArr.size() };
+			size_t moved{ 0 };
+			for (size_t start{ 0 }; start < count; ++start)
+			{
+				if (perm[start] == start)
+				{
+					continue;
+				}
+
+				Val temp{ std::move(m_PackedValArr[start]) };
+				KeyType const tempKey{ m_DenseArr[start] };
+
+				size_t curr{ start };
+				size_t next{ perm[curr] };
+				while (next != start)
+				{
+					Impl::assign_value(m_PackedValArr[curr], std::move(m_PackedValArr[next]));
+					m_DenseArr[curr] = m_DenseArr[next];
+
+					perm[curr] = curr;
+					curr = next;
+					next = perm[curr];
+					++moved;
+				}
+
+				Impl::assign_value(m_PackedValArr[curr], std::move(temp));
+				m_DenseArr[curr] = tempKey;
+				perm[curr] = curr;
+				++moved;
+			}
+
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				m_SparseArr[m_DenseArr[i]] = static_cast<dense_type>(i);
+			}
+
+			m_Stats.on_sort(moved);
+		}
+
+		static constexpr size_t PARALLEL_MIN_CHUNK{ 1024 };
+		static constexpr size_t PARALLEL_TASKS_PER_THREAD{ 4 };
+		static constexpr size_t REDUCE_BLOCK_SIZE{ 4096 };
+
+		//Amount of threads work can be spread over, the calling thread helps as well
+		template<typename Executor>
+		[[nodiscard]] static size_t executor_width(Executor const& executor) noexcept
+		{
+			if constexpr (requires { executor.thread_count(); })
+			{
+				return executor.thread_count() + 1;
+			}
+			else
+			{
+				return Impl::resolve_thread_count(0);
+			}
+		}
+
+		//Splits the dense range in a few chunks per thread, so stealing can balance uneven work.
+		//Inner chunk boundaries are moved to the start of a cache line of the packed values.
+		template<typename Executor, typename Func>
+		void parallel_chunks(Executor& executor, Func&& func)
+		{
+			size_t const count{ m_PackedValArr.size() };
+			if (count == 0)
+			{
+				return;
+			}
+
+			size_t const chunkCount{ std::clamp<size_t>(count / PARALLEL_MIN_CHUNK, 1, executor_width(executor) * PARALLEL_TASKS_PER_THREAD) };
+			size_t const chunkSize{ (count + chunkCount - 1) / chunkCount };
+			Val const* const base{ m_PackedValArr.data() };
+
+			auto const boundary = [=](size_t chunk) noexcept
+				{
+					if (chunk == 0 || chunk == chunkCount)
+					{
+						return chunk == 0 ? size_t{ 0 } : count;
+					}
+					return std::min(Impl::cache_line_boundary(base, sizeof(Val), chunk * chunkSize), count);
+				};
+
+			Impl::run_chunks(executor, chunkCount, [&func, &boundary](size_t chunk) { func(boundary(chunk), boundary(chunk + 1)); });
+		}
+
+		template<typename Executor, typename Compare>
+		void sort_on(Executor& executor, Compare& compare)
+		{
+			size_t const count{ m_DenseArr.size() };
+			size_t const runCount{ std::clamp<size_t>(count / PARALLEL_MIN_CHUNK, 1, executor_width(executor)) };
+
+			m_SortPerm.resize(count * 2);
+			size_t* perm{ m_SortPerm.data() };
+			size_t* permOut{ perm + count };
+
+			auto const less{ [this, &compare](size_t lhs, size_t rhs) { return std::invoke(compare, m_PackedValArr[lhs], m_PackedValArr[rhs]); } };
+
+			//Sort one run per thread
+			size_t const runSize{ (count + runCount - 1) / runCount };
+			Impl::run_chunks(executor, runCount, [&](size_t run)
+				{
+					size_t const begin{ std::min(run * runSize, count) };
+					size_t const end{ std::min(begin + runSize, count) };
+
+					std::iota(perm + begin, perm + end, begin);
+					std::sort(perm + begin, perm + end, less);
+				});
+
+			//Merge neighbouring runs until one run is left
+			for (size_t width{ runSize }; width < count; width *= 2)
+			{
+				size_t const merges{ (count + 2 * width - 1) / (2 * width) };
+				Impl::run_chunks(executor, merges, [&](size_t merge)
+					{
+						size_t const begin{ merge * 2 * width };
+						size_t const mid{ std::min(begin + width, count) };
+						size_t const end{ std::min(begin + 2 * width, count) };
+
+						std::merge(perm + begin, perm + mid, perm + mid, perm + end, permOut + begin, less);
+					});
+
+				std::swap(perm, permOut);
+			}
+
+			if constexpr (std::is_default_constructible_v<Val> && (std::is_trivially_copyable_v<Val> || Impl::MoveAssignmentVal<Val>))
+			{
+				if constexpr (stats_recorder::enabled)
+				{
+					size_t moved{ 0 };
+					for (size_t i{ 0 }; i < count; ++i)
+					{
+						moved += perm[i] != i ? size_t{ 1 } : size_t{ 0 };
+					}
+					m_Stats.on_sort(moved);
+				}
+
+				//Gather the values into the double buffer and swap it in
+				m_SortValues.resize(count);
+				parallel_chunks(executor, [this, perm](size_t first, size_t last)
+					{
+						for (size_t i{ first }; i < last; ++i)
+						{
+							Impl::assign_value(m_SortValues[i], std::move(m_PackedValArr[perm[i]]));
+						}
+					});
+
+				m_PackedValArr.swap(m_SortValues);
+				m_SortValues.clear();
+
+				//Gather the keys through the key scratch buffer, then fix up the sparse storage (every thread writes distinct entries)
+				m_SortKeys.resize(count);
+				parallel_chunks(executor, [this, perm](size_t first, size_t last)
+					{
+						for (size_t i{ first }; i < last; ++i)
+						{
+							m_SortKeys[i] = m_DenseArr[perm[i]];
+						}
+					});
+
+				parallel_chunks(executor, [this](size_t first, size_t last)
+					{
+						for (size_t i{ first }; i < last; ++i)
+						{
+							m_DenseArr[i] = static_cast<KeyType>(m_SortKeys[i]);
+							m_SparseArr[m_DenseArr[i]] = static_cast<dense_type>(i);
+						}
+					});
+			}
+			else
+			{
+				//Values that can not live in a default constructed buffer are moved along the permutation cycles
+				apply_permutation(perm);
+			}
+		}
+
+		//Stable LSD radix sort on the integral key of every element (8 bits per pass), passes where all keys share the digit are skipped.
+		template<typename KeyAt>
+		void radix_sort(KeyAt&& keyAt) noexcept
+		{
+			using SortKey = std::remove_cvref_t<std::invoke_result_t<KeyAt&, size_t>>;
+			using UnsignedKey = std::make_unsigned_t<SortKey>;
+
+			size_t const count{ m_DenseArr.size() };
+			m_SortKeys.resize(count * 2);
+			m_SortPerm.resize(count * 2);
+
+			uint64_t* keys{ m_SortKeys.data() };
+			uint64_t* keysOut{ keys + count };
+			size_t* perm{ m_SortPerm.data() };
+			size_t* permOut{ perm + count };
+
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				UnsignedKey key{ static_cast<UnsignedKey>(keyAt(i)) };
+				if constexpr (std::is_signed_v<SortKey>)
+				{
+					//Flip the sign bit so negative keys order before positive ones
+					key ^= static_cast<UnsignedKey>(UnsignedKey{ 1 } << (sizeof(UnsignedKey) * 8 - 1));
+				}
+
+				keys[i] = key;
+				perm[i] = i;
+			}
+
+			for (size_t shift{ 0 }; shift < sizeof(UnsignedKey) * 8; shift += 8)
+			{
+				std::array<size_t, 256> offsets{ };
+				for (size_t i{ 0 }; i < count; ++i)
+				{
+					++offsets[static_cast<size_t>((keys[i] >> shift) & 0xFF)];
+				}
+
+				if (std::find(offsets.begin(), offsets.end(), count) != offsets.end())
+				{
+					continue;
+				}
+
+				std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), size_t{ 0 });
+
+				for (size_t i{ 0 }; i < count; ++i)
+				{
+					size_t const pos{ offsets[static_cast<size_t>((keys[i] >> shift) & 0xFF)]++ };
+					keysOut[pos] = keys[i];
+					permOut[pos] = perm[i];
+				}
+
+				std::swap(keys, keysOut);
+				std::swap(perm, permOut);
+			}
+
+			apply_permutation(perm);
+		}
+
+		//Moves the element at dense index src into dense index dst and points its sparse entry to the new slot, the element at dst must already be released
+		void relocate(size_t dst, size_t src) noexcept
+		{
+			move_value(dst, src);
+			m_DenseArr[dst] = m_DenseArr[src];
+			m_SparseArr[m_DenseArr[dst]] = static_cast<dense_type>(dst);
+		}
+
+		//Drops every element from newSize onwards at once, the elements must already be released from the sparse storage
+		void truncate(size_t newSize) noexcept
+		{
+			ASSERT(newSize <= m_DenseArr.size(), "Can not truncate to a larger size!");
+
+			m_DenseArr.resize(newSize);
+			while (m_PackedValArr.size() > newSize)
+			{
+				m_PackedValArr.pop_back();
+			}
+		}
+
+		//Sizes the sparse storage once for the largest key and reserves the dense and packed storage for the whole batch
+		void bulk_prepare(std::span<const KeyType> keys) noexcept
+		{
+			if (keys.empty())
+			{
+				return;
+			}
+
+			KeyType const maxKey{ *std::max_element(keys.begin(), keys.end()) };
+			ASSERT(maxKey != INVALID_KEY, "Element must be a valid index!");
+			ASSERT(m_DenseArr.size() + keys.size() <= max_size(), "Dense index type is full!");
+
+			if (maxKey >= m_SparseArr.size())
+			{
+				m_SparseArr.resize(static_cast<size_t>(maxKey) + 1);
+			}
+
+			//Not through reserve, the caller records the allocations of the whole batch once
+			m_DenseArr.reserve(m_DenseArr.size() + keys.size());
+			m_PackedValArr.reserve(m_PackedValArr.size() + keys.size());
+		}
+
+		template<typename InputIt>
+		void bulk_append(InputIt first, InputIt last) noexcept
+		{
+			if constexpr (std::is_trivially_copyable_v<Val>)
+			{
+				m_PackedValArr.insert(m_PackedValArr.end(), first, last);
+			}
+			else
+			{
+				for (; first != last; ++first)
+				{
+					m_PackedValArr.emplace_back(*first);
+				}
+			}
+		}
+
+	private:
+		//Capacities before a change, compared afterwards to count the reallocations it caused. Empty work without collect_stats.
+		struct allocation_probe final
+		{
+			size_t sparse{ 0 };
+			size_t dense{ 0 };
+			size_t packed{ 0 };
+		};
+
+		[[nodiscard]] allocation_probe probe_allocations() const noexcept
+		{
+			if constexpr (stats_recorder::enabled)
+			{
+				if constexpr (requires { m_SparseArr.capacity(); })
+				{
+					return { m_SparseArr.capacity(), m_DenseArr.capacity(), m_PackedValArr.capacity() };
+				}
+				else
+				{
+					return { m_SparseArr.size(), m_DenseArr.capacity(), m_PackedValArr.capacity() };
+				}
+			}
+			else
+			{
+				return { };
+			}
+		}
+
+		void record_allocations(allocation_probe before) noexcept
+		{
+			if constexpr (stats_recorder::enabled)
+			{
+				allocation_probe const after{ probe_allocations() };
+				if (after.sparse != before.sparse)
+				{
+					m_Stats.on_sparse_resize();
+				}
+				if (after.dense != before.dense || after.packed != before.packed)
+				{
+					m_Stats.on_dense_resize();
+				}
+			}
+		}
+
 	private:
 		template <Impl::Compare<Val> Compare = std::less< >>
 		iterator lower_bound(const Val& value, Compare&& compare = { }) noexcept
@@ -575,6 +1991,45 @@ namespace Internal
 			return std::lower_bound(m_PackedValArr.begin(), m_PackedValArr.end(), value, std::forward<Compare>(compare));
 		}
 	};
+
+	//Set algebra over the keys of two sets with the bitset_sparse policy, the result is a bitset of keys (use each() to walk it).
+	//Runs over the presence bitsets 256 bits at a time, only the key ranges both summaries mark as occupied are touched.
+	template<typename SetA, typename SetB>
+	requires Impl::PresenceStorage<typename SetA::sparse_storage> && Impl::PresenceStorage<typename SetB::sparse_storage>
+	[[nodiscard]] auto set_intersection(const SetA& a, const SetB& b)
+	{
+		using bitset_type = std::remove_cvref_t<decltype(a.presence())>;
+		return bitset_type::intersection(a.presence(), b.presence());
+	}
+
+	template<typename SetA, typename SetB>
+	requires Impl::PresenceStorage<typename SetA::sparse_storage> && Impl::PresenceStorage<typename SetB::sparse_storage>
+	[[nodiscard]] auto set_union(const SetA& a, const SetB& b)
+	{
+		using bitset_type = std::remove_cvref_t<decltype(a.presence())>;
+		return bitset_type::unite(a.presence(), b.presence());
+	}
+
+	//Keys of a that are not in b
+	template<typename SetA, typename SetB>
+	requires Impl::PresenceStorage<typename SetA::sparse_storage> && Impl::PresenceStorage<typename SetB::sparse_storage>
+	[[nodiscard]] auto set_difference(const SetA& a, const SetB& b)
+	{
+		using bitset_type = std::remove_cvref_t<decltype(a.presence())>;
+		return bitset_type::difference(a.presence(), b.presence());
+	}
+
+	//sparse_set that journals its changes, see track_changes
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t, Impl::SparsePolicy<KeyType> SparsePolicy = flat_sparse, typename Allocator = std::allocator<Val>>
+	using tracked_sparse_set = sparse_set<Val, KeyType, SparsePolicy, Allocator, KeyType, track_changes>;
+
+	namespace pmr
+	{
+		//sparse_set on a memory resource, e.g. a std::pmr::monotonic_buffer_resource that is released all at once
+		template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t, Impl::SparsePolicy<KeyType> SparsePolicy = flat_sparse, Impl::KeyType DenseIndex = KeyType,
+				 Impl::ChangeTrackingPolicy<KeyType> ChangeTracking = no_change_tracking, Impl::StatsPolicy Stats = no_stats>
+		using sparse_set = Internal::sparse_set<Val, KeyType, SparsePolicy, std::pmr::polymorphic_allocator<Val>, DenseIndex, ChangeTracking, Stats>;
+	}
 }
 
 #endif
\ No newline at end of file
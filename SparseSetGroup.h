@@ -0,0 +1,178 @@
+#ifndef SPARSE_SET_GROUP
+#define SPARSE_SET_GROUP
+
+#include <tuple>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	//Owns two or more sparse_sets and keeps the keys they share packed at the front of every set, at the same dense index.
+	//Emplacing into or erasing from an owned set keeps the group up to date, iterating the group is a linear walk over parallel arrays.
+	//Owned sets can not be sorted, moved or swapped while the group exists, and the sets must outlive the group.
+	template<typename... Sets>
+	class owning_group final : private Impl::sparse_set_owner<typename std::tuple_element_t<0, std::tuple<Sets...>>::key_type>
+	{
+		static_assert(sizeof...(Sets) > 1, "A group needs at least two sets");
+
+		using first_set = std::tuple_element_t<0, std::tuple<Sets...>>;
+
+	public:
+		using key_type = typename first_set::key_type;
+		using value_type = std::tuple<key_type, typename Sets::value_type&...>;
+
+		static_assert((std::is_same_v<key_type, typename Sets::key_type> && ...), "All owned sets must share the key type");
+
+		explicit owning_group(Sets&... sets) noexcept :
+			m_Sets{ &sets... }
+		{
+			std::apply([this](auto*... sets)
+				{
+					ASSERT(!(sets->owned() || ...), "A set can only be owned by one group!");
+					((sets->m_Owner = this), ...);
+				}, m_Sets);
+
+			//Pull in the shared keys, the smallest set bounds the group
+			size_t driver{ 0 };
+			size_t driverSize{ std::get<0>(m_Sets)->size() };
+			[&, this]<size_t... I>(std::index_sequence<I...>)
+			{
+				((std::get<I>(m_Sets)->size() < driverSize ? (driver = I, driverSize = std::get<I>(m_Sets)->size(), void()) : void()), ...);
+
+				((I == driver ? add_all(*std::get<I>(m_Sets)) : void()), ...);
+			}(std::index_sequence_for<Sets...>{ });
+		}
+
+		~owning_group() noexcept
+		{
+			std::apply([](auto*... sets) { ((sets->m_Owner = nullptr), ...); }, m_Sets);
+		}
+
+		owning_group(const owning_group&) = delete;
+		owning_group& operator=(const owning_group&) = delete;
+		owning_group(owning_group&&) = delete;
+		owning_group& operator=(owning_group&&) = delete;
+
+	public:
+		class iterator final
+		{
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = typename owning_group::value_type;
+			using reference = value_type;
+			using pointer = void;
+
+			iterator() noexcept = default;
+			iterator(const owning_group* group, size_t pos) noexcept :
+				m_Group{ group },
+				m_Pos{ pos }
+			{ }
+
+			[[nodiscard]] reference operator*() const noexcept { return m_Group->get_at(m_Pos); }
+			[[nodiscard]] reference operator[](difference_type offset) const noexcept { return m_Group->get_at(m_Pos + offset); }
+
+			iterator& operator++() noexcept { ++m_Pos; return *this; }
+			iterator operator++(int) noexcept { iterator const temp{ *this }; ++m_Pos; return temp; }
+			iterator& operator--() noexcept { --m_Pos; return *this; }
+			iterator operator--(int) noexcept { iterator const temp{ *this }; --m_Pos; return temp; }
+
+			iterator& operator+=(difference_type offset) noexcept { m_Pos += offset; return *this; }
+			iterator& operator-=(difference_type offset) noexcept { m_Pos -= offset; return *this; }
+			[[nodiscard]] iterator operator+(difference_type offset) const noexcept { return iterator{ m_Group, m_Pos + offset }; }
+			[[nodiscard]] friend iterator operator+(difference_type offset, const iterator& it) noexcept { return it + offset; }
+			[[nodiscard]] iterator operator-(difference_type offset) const noexcept { return iterator{ m_Group, m_Pos - offset }; }
+			[[nodiscard]] difference_type operator-(const iterator& other) const noexcept
+			{
+				return static_cast<difference_type>(m_Pos) - static_cast<difference_type>(other.m_Pos);
+			}
+
+			[[nodiscard]] bool operator==(const iterator& other) const noexcept { return m_Pos == other.m_Pos; }
+			[[nodiscard]] auto operator<=>(const iterator& other) const noexcept { return m_Pos <=> other.m_Pos; }
+
+		private:
+			const owning_group* m_Group{ nullptr };
+			size_t m_Pos{ 0 };
+		};
+
+		[[nodiscard]] iterator begin() const noexcept { return iterator{ this, 0 }; }
+		[[nodiscard]] iterator end() const noexcept { return iterator{ this, m_Size }; }
+
+	public:
+		[[nodiscard]] size_t size() const noexcept { return m_Size; }
+		[[nodiscard]] bool empty() const noexcept { return m_Size == 0; }
+
+		[[nodiscard]] bool contains(key_type key) const noexcept
+		{
+			return std::get<0>(m_Sets)->contains(key) && std::get<0>(m_Sets)->index(key) < m_Size;
+		}
+
+		//Calls func(key, Val&...) for every key in the group, walking the owned sets in lockstep
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			auto const& keys{ std::get<0>(m_Sets)->dense() };
+			std::apply([&func, &keys, this](auto*... sets)
+				{
+					auto const values{ std::make_tuple(sets->begin()...) };
+					for (size_t i{ 0 }; i < m_Size; ++i)
+					{
+						std::apply([&func, &keys, i](auto const&... it) { std::invoke(func, keys[i], it[i]...); }, values);
+					}
+				}, m_Sets);
+		}
+
+	private:
+		std::tuple<Sets*...> m_Sets;
+		size_t m_Size{ 0 };
+
+		[[nodiscard]] value_type get_at(size_t pos) const noexcept
+		{
+			ASSERT(pos < m_Size, "Position out of the group!");
+			key_type const key{ std::get<0>(m_Sets)->dense()[pos] };
+			return std::apply([pos, key](auto*... sets) { return value_type{ key, sets->begin()[pos]... }; }, m_Sets);
+		}
+
+		template<typename Set>
+		void add_all(Set const& driver) noexcept
+		{
+			for (size_t i{ 0 }; i < driver.size(); ++i)
+			{
+				on_emplace(driver.dense()[i]);
+			}
+		}
+
+		void on_emplace(key_type element) noexcept override
+		{
+			bool const shared{ std::apply([element](auto*... sets) { return (sets->contains(element) && ...); }, m_Sets) };
+			if (!shared || std::get<0>(m_Sets)->index(element) < m_Size)
+			{
+				return;
+			}
+
+			std::apply([this, element](auto*... sets) { (sets->swap_at(sets->index(element), m_Size), ...); }, m_Sets);
+			++m_Size;
+		}
+
+		void on_erase(key_type element) noexcept override
+		{
+			if (!contains(element))
+			{
+				return;
+			}
+
+			--m_Size;
+			std::apply([this, element](auto*... sets) { (sets->swap_at(sets->index(element), m_Size), ...); }, m_Sets);
+		}
+
+		void on_clear() noexcept override
+		{
+			m_Size = 0;
+		}
+	};
+}
+
+#endif
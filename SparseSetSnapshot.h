@@ -0,0 +1,201 @@
+#ifndef SPARSE_SET_SNAPSHOT
+#define SPARSE_SET_SNAPSHOT
+
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <bit>
+
+namespace Internal
+{
+	//Thrown when a snapshot can not be written, read or mapped, or does not match the set it is loaded into
+	class sparse_set_snapshot_error : public std::runtime_error
+	{
+	public:
+		sparse_set_snapshot_error(const std::string& message, const std::filesystem::path& path) :
+			std::runtime_error{ message + ": " + path.string() },
+			m_Path{ path }
+		{ }
+
+		[[nodiscard]] const std::filesystem::path& path() const noexcept
+		{
+			return m_Path;
+		}
+
+	private:
+		std::filesystem::path m_Path;
+	};
+
+	namespace Impl
+	{
+		//Snapshot layout: the header, then the sparse, dense and packed arrays as raw blocks, each starting on a SNAPSHOT_ALIGNMENT boundary.
+		//Everything is stored in native byte order, the sparse block is empty for policies without one contiguous sparse array.
+		inline constexpr uint32_t SNAPSHOT_MAGIC{ 0x54455353 }; //"SSET"
+		inline constexpr uint32_t SNAPSHOT_MAGIC_SWAPPED{ 0x53534554 };
+		inline constexpr uint32_t SNAPSHOT_VERSION{ 1 };
+		inline constexpr size_t SNAPSHOT_ALIGNMENT{ 64 };
+
+		struct snapshot_header final
+		{
+			uint32_t magic;
+			uint32_t version;
+
+			uint32_t keySize;
+			uint32_t denseSize;
+			uint32_t valueSize;
+			uint32_t valueAlign;
+
+			uint64_t sparseCount;
+			uint64_t count;
+
+			uint64_t sparseOffset;
+			uint64_t denseOffset;
+			uint64_t valuesOffset;
+
+			uint64_t sparseChecksum;
+			uint64_t denseChecksum;
+			uint64_t valuesChecksum;
+
+			//Over every field above
+			uint64_t headerChecksum;
+		};
+
+		[[nodiscard]] constexpr uint64_t snapshot_align(uint64_t offset) noexcept
+		{
+			return (offset + SNAPSHOT_ALIGNMENT - 1) & ~uint64_t{ SNAPSHOT_ALIGNMENT - 1 };
+		}
+
+		//Four independent multiply-rotate lanes over 8 byte words, fast enough to verify multi GB blocks at memory bandwidth
+		[[nodiscard]] inline uint64_t snapshot_checksum(const void* data, size_t size) noexcept
+		{
+			constexpr uint64_t PRIME1{ 0x9E3779B185EBCA87ull };
+			constexpr uint64_t PRIME2{ 0xC2B2AE3D27D4EB4Full };
+
+			auto const* bytes{ static_cast<const unsigned char*>(data) };
+			uint64_t lanes[4]{ PRIME1, PRIME2, ~PRIME1, ~PRIME2 };
+
+			size_t i{ 0 };
+			for (; i + 32 <= size; i += 32)
+			{
+				for (size_t lane{ 0 }; lane < 4; ++lane)
+				{
+					uint64_t word;
+					std::memcpy(&word, bytes + i + lane * 8, sizeof(word));
+					lanes[lane] = std::rotl(lanes[lane] + word * PRIME2, 31) * PRIME1;
+				}
+			}
+
+			uint64_t hash{ static_cast<uint64_t>(size) * PRIME1 };
+			for (uint64_t const lane : lanes)
+			{
+				hash = std::rotl(hash ^ lane, 27) * PRIME1 + PRIME2;
+			}
+			for (; i < size; ++i)
+			{
+				hash = std::rotl(hash ^ bytes[i], 11) * PRIME1;
+			}
+
+			hash ^= hash >> 33;
+			hash *= PRIME2;
+			hash ^= hash >> 29;
+			return hash;
+		}
+
+		[[nodiscard]] inline uint64_t snapshot_header_checksum(const snapshot_header& header) noexcept
+		{
+			return snapshot_checksum(&header, offsetof(snapshot_header, headerChecksum));
+		}
+
+		//Checks everything that can be checked without touching the blocks, fileSize is the size of the whole file
+		inline void validate_snapshot_header(const snapshot_header& header, uint64_t fileSize,
+											 size_t keySize, size_t denseSize, size_t valueSize, size_t valueAlign, const std::filesystem::path& path)
+		{
+			if (header.magic != SNAPSHOT_MAGIC)
+			{
+				throw sparse_set_snapshot_error{ header.magic == SNAPSHOT_MAGIC_SWAPPED ? "Snapshot has a different byte order" : "Not a sparse_set snapshot", path };
+			}
+			if (header.version != SNAPSHOT_VERSION)
+			{
+				throw sparse_set_snapshot_error{ "Unsupported snapshot version " + std::to_string(header.version), path };
+			}
+			if (header.headerChecksum != snapshot_header_checksum(header))
+			{
+				throw sparse_set_snapshot_error{ "Snapshot header is corrupted", path };
+			}
+			if (header.keySize != keySize || header.denseSize != denseSize || header.valueSize != valueSize || header.valueAlign != valueAlign)
+			{
+				throw sparse_set_snapshot_error{ "Snapshot was written for different key, index or value types", path };
+			}
+
+			auto const fits = [fileSize](uint64_t offset, uint64_t count, uint64_t elementSize)
+				{
+					return offset % SNAPSHOT_ALIGNMENT == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+				};
+			if (!fits(header.sparseOffset, header.sparseCount, denseSize) || !fits(header.denseOffset, header.count, keySize)
+				|| !fits(header.valuesOffset, header.count, valueSize))
+			{
+				throw sparse_set_snapshot_error{ "Snapshot is truncated", path };
+			}
+		}
+
+		//Writes the header and the three blocks, sizes are in bytes
+		inline void write_snapshot(const std::filesystem::path& path, snapshot_header header,
+								   const void* sparse, size_t sparseBytes, const void* dense, size_t denseBytes, const void* values, size_t valueBytes)
+		{
+			header.magic = SNAPSHOT_MAGIC;
+			header.version = SNAPSHOT_VERSION;
+			header.sparseOffset = snapshot_align(sizeof(snapshot_header));
+			header.denseOffset = snapshot_align(header.sparseOffset + sparseBytes);
+			header.valuesOffset = snapshot_align(header.denseOffset + denseBytes);
+			header.sparseChecksum = snapshot_checksum(sparse, sparseBytes);
+			header.denseChecksum = snapshot_checksum(dense, denseBytes);
+			header.valuesChecksum = snapshot_checksum(values, valueBytes);
+			header.headerChecksum = snapshot_header_checksum(header);
+
+			std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+			if (!file)
+			{
+				throw sparse_set_snapshot_error{ "Can not open snapshot for writing", path };
+			}
+
+			char const padding[SNAPSHOT_ALIGNMENT]{ };
+			uint64_t written{ 0 };
+			auto const write = [&file, &padding, &written](uint64_t offset, const void* data, size_t size)
+				{
+					file.write(padding, static_cast<std::streamsize>(offset - written));
+					file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+					written = offset + size;
+				};
+
+			write(0, &header, sizeof(header));
+			write(header.sparseOffset, sparse, sparseBytes);
+			write(header.denseOffset, dense, denseBytes);
+			write(header.valuesOffset, values, valueBytes);
+
+			if (!file.flush())
+			{
+				throw sparse_set_snapshot_error{ "Failed to write snapshot", path };
+			}
+		}
+
+		//Reads one block straight into its destination and verifies it
+		inline void read_snapshot_block(std::ifstream& file, uint64_t offset, void* data, size_t size, uint64_t checksum, const std::filesystem::path& path)
+		{
+			file.seekg(static_cast<std::streamoff>(offset));
+			if (!file.read(static_cast<char*>(data), static_cast<std::streamsize>(size)))
+			{
+				throw sparse_set_snapshot_error{ "Snapshot is truncated", path };
+			}
+			if (snapshot_checksum(data, size) != checksum)
+			{
+				throw sparse_set_snapshot_error{ "Snapshot block is corrupted", path };
+			}
+		}
+	}
+}
+
+#endif
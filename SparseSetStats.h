@@ -0,0 +1,154 @@
+#ifndef SPARSE_SET_STATS
+#define SPARSE_SET_STATS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <concepts>
+
+namespace Internal
+{
+	//Event counts of one set since it was created or the last reset_stats, see collect_stats
+	struct sparse_set_counters final
+	{
+		uint64_t emplaces{ 0 };
+		uint64_t erases{ 0 };
+		uint64_t eraseMoves{ 0 };			//Elements moved to fill the holes of erased ones
+		uint64_t sparseResizes{ 0 };		//Changes of the sparse storage capacity
+		uint64_t denseResizes{ 0 };			//Changes of the dense or packed capacity
+		uint64_t sorts{ 0 };
+		uint64_t sortMoves{ 0 };			//Elements moved by sorts and sorted inserts
+		uint64_t swaps{ 0 };				//Element swaps, including the ones of owning groups
+		uint64_t lookupMisses{ 0 };			//contains, find, at and remove calls on keys that are not in the set, try_* inserts do not count
+	};
+
+	//Memory of one set in bytes, capacity is what is allocated and size what the elements use
+	struct sparse_set_memory_usage final
+	{
+		size_t sparseBytes{ 0 };
+		size_t sparseSlots{ 0 };			//Keys the sparse storage can hold without growing
+		size_t denseBytes{ 0 };
+		size_t denseCapacityBytes{ 0 };
+		size_t packedBytes{ 0 };
+		size_t packedCapacityBytes{ 0 };
+		size_t sortBufferBytes{ 0 };
+		//Elements per sparse slot, low values mean most of the sparse storage maps nothing
+		double sparseOccupancy{ 0 };
+
+		[[nodiscard]] size_t total_bytes() const noexcept
+		{
+			return sparseBytes + denseCapacityBytes + packedCapacityBytes + sortBufferBytes;
+		}
+	};
+
+	namespace Impl
+	{
+		//Default recorder, every hook is empty and the recorder takes no space in the set
+		struct null_stats_recorder final
+		{
+			static constexpr bool enabled{ false };
+
+			void on_emplace(size_t) noexcept { }
+			void on_erase(size_t, size_t) noexcept { }
+			void on_sparse_resize() noexcept { }
+			void on_dense_resize() noexcept { }
+			void on_sort(size_t) noexcept { }
+			void on_sorted_insert(size_t) noexcept { }
+			void on_swap() noexcept { }
+			void on_lookup_miss(size_t = 1) const noexcept { }
+		};
+
+		//Plain counters, only the miss counter is written by const lookups.
+		//Concurrent readers may lose misses against each other but never tear the count.
+		class stats_recorder final
+		{
+		public:
+			static constexpr bool enabled{ true };
+
+			stats_recorder() noexcept = default;
+			~stats_recorder() noexcept = default;
+
+			stats_recorder(const stats_recorder& other) noexcept :
+				m_Counters{ other.m_Counters },
+				m_LookupMisses{ other.m_LookupMisses.load(std::memory_order_relaxed) }
+			{ }
+
+			stats_recorder& operator=(const stats_recorder& other) noexcept
+			{
+				m_Counters = other.m_Counters;
+				m_LookupMisses.store(other.m_LookupMisses.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				return *this;
+			}
+
+		public:
+			void on_emplace(size_t count) noexcept { m_Counters.emplaces += count; }
+			void on_erase(size_t count, size_t moved) noexcept
+			{
+				m_Counters.erases += count;
+				m_Counters.eraseMoves += moved;
+			}
+			void on_sparse_resize() noexcept { ++m_Counters.sparseResizes; }
+			void on_dense_resize() noexcept { ++m_Counters.denseResizes; }
+			void on_sort(size_t moved) noexcept
+			{
+				++m_Counters.sorts;
+				m_Counters.sortMoves += moved;
+			}
+			void on_sorted_insert(size_t moved) noexcept { m_Counters.sortMoves += moved; }
+			void on_swap() noexcept { ++m_Counters.swaps; }
+			void on_lookup_miss(size_t count = 1) const noexcept
+			{
+				m_LookupMisses.store(m_LookupMisses.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+			}
+
+		public:
+			[[nodiscard]] sparse_set_counters counters() const noexcept
+			{
+				sparse_set_counters counters{ m_Counters };
+				counters.lookupMisses = m_LookupMisses.load(std::memory_order_relaxed);
+				return counters;
+			}
+
+			void reset() noexcept
+			{
+				m_Counters = { };
+				m_LookupMisses.store(0, std::memory_order_relaxed);
+			}
+
+		private:
+			sparse_set_counters m_Counters{ };
+			mutable std::atomic<uint64_t> m_LookupMisses{ 0 };
+		};
+
+		template<typename P>
+		concept StatsPolicy = requires(typename P::recorder_type recorder, const typename P::recorder_type constRecorder, size_t count)
+		{
+			{ recorder.enabled } -> std::convertible_to<bool>;
+			recorder.on_emplace(count);
+			recorder.on_erase(count, count);
+			recorder.on_sparse_resize();
+			recorder.on_dense_resize();
+			recorder.on_sort(count);
+			recorder.on_sorted_insert(count);
+			recorder.on_swap();
+			constRecorder.on_lookup_miss(count);
+		};
+	}
+
+	//Statistics policies, select whether sparse_set counts what it does. memory_usage is available either way.
+
+	//No counters (default), costs nothing.
+	struct no_stats final
+	{
+		using recorder_type = Impl::null_stats_recorder;
+	};
+
+	//Counts emplaces, erases, reallocations, sorts, swaps and lookup misses, read them with stats().
+	//Every hook is a few increments, the reallocation checks compare two capacities per insert.
+	struct collect_stats final
+	{
+		using recorder_type = Impl::stats_recorder;
+	};
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef SPARSE_SET_VIEW
+#define SPARSE_SET_VIEW
+
+#include <tuple>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <span>
+#include <limits>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	//Type lists used to tell the included sets apart from the excluded sets of a view
+	template<typename... Sets>
+	struct get_t final { };
+
+	template<typename... Sets>
+	struct exclude_t final { };
+
+	template<typename Get, typename Exclude = exclude_t<>>
+	class sparse_view;
+
+	//Joins several sparse_sets (with possibly different value types) on their keys.
+	//Iterates the keys that are in all included sets and none of the excluded sets, yielding (key, Val&...) tuples.
+	//The smallest included set drives the iteration, iteration does not allocate.
+	//The sets must outlive the view and must not be resized while iterating.
+	template<typename... Includes, typename... Excludes>
+	class sparse_view<get_t<Includes...>, exclude_t<Excludes...>> final
+	{
+		static_assert(sizeof...(Includes) > 0, "A view needs at least one included set");
+
+		using first_set = std::tuple_element_t<0, std::tuple<Includes...>>;
+
+	public:
+		using key_type = typename std::remove_const_t<first_set>::key_type;
+		using value_type = std::tuple<key_type, decltype(std::declval<Includes&>()[key_type{ }])...>;
+
+		static_assert((std::is_same_v<key_type, typename std::remove_const_t<Includes>::key_type> && ...), "All included sets must share the key type");
+		static_assert((std::is_same_v<key_type, typename std::remove_const_t<Excludes>::key_type> && ...), "All excluded sets must share the key type");
+
+		sparse_view(Includes&... includes, Excludes&... excludes) noexcept :
+			m_Includes{ &includes... },
+			m_Excludes{ &excludes... }
+		{
+			refresh();
+		}
+
+		~sparse_view() noexcept = default;
+
+		sparse_view(const sparse_view&) noexcept = default;
+		sparse_view& operator=(const sparse_view&) noexcept = default;
+		sparse_view(sparse_view&&) noexcept = default;
+		sparse_view& operator=(sparse_view&&) noexcept = default;
+
+	public:
+		class iterator final
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = typename sparse_view::value_type;
+			using reference = value_type;
+			using pointer = void;
+
+			iterator() noexcept = default;
+			iterator(const sparse_view* view, size_t pos) noexcept :
+				m_View{ view },
+				m_Keys{ view->driver() },
+				m_Pos{ pos }
+			{
+				skip();
+			}
+
+			[[nodiscard]] reference operator*() const noexcept
+			{
+				return m_View->get(m_Keys[m_Pos]);
+			}
+
+			iterator& operator++() noexcept
+			{
+				++m_Pos;
+				skip();
+				return *this;
+			}
+			iterator operator++(int) noexcept
+			{
+				iterator const temp{ *this };
+				++(*this);
+				return temp;
+			}
+
+			[[nodiscard]] bool operator==(const iterator& other) const noexcept { return m_Pos == other.m_Pos; }
+
+		private:
+			const sparse_view* m_View{ nullptr };
+			std::span<const key_type> m_Keys{ };
+			size_t m_Pos{ 0 };
+
+			void skip() noexcept
+			{
+				while (m_Pos < m_Keys.size() && !m_View->matches(m_Keys[m_Pos]))
+				{
+					++m_Pos;
+				}
+			}
+		};
+
+		[[nodiscard]] iterator begin() const noexcept { return iterator{ this, 0 }; }
+		[[nodiscard]] iterator end() const noexcept { return iterator{ this, driver().size() }; }
+
+	public:
+		//Picks the smallest included set as the driver again, call after the sizes of the sets changed a lot
+		void refresh() noexcept
+		{
+			m_DriverIdx = 0;
+			size_t driverSize{ std::get<0>(m_Includes)->size() };
+
+			[this, &driverSize]<size_t... I>(std::index_sequence<I...>)
+			{
+				((std::get<I>(m_Includes)->size() < driverSize
+					? (driverSize = std::get<I>(m_Includes)->size(), m_DriverIdx = I, void())
+					: void()), ...);
+			}(std::index_sequence_for<Includes...>{ });
+		}
+
+		//Upper bound on the amount of keys the view yields
+		[[nodiscard]] size_t size_hint() const noexcept { return driver().size(); }
+
+		[[nodiscard]] bool contains(key_type key) const noexcept
+		{
+			return std::apply([key](auto*... sets) { return (sets->contains(key) && ...); }, m_Includes)
+				&& std::apply([key](auto*... sets) { return !(sets->contains(key) || ...); }, m_Excludes);
+		}
+
+		//Key must be in the view
+		[[nodiscard]] value_type get(key_type key) const noexcept
+		{
+			ASSERT(contains(key), "Key not in view!");
+			return std::apply([key](auto*... sets) { return value_type{ key, (*sets)[key]... }; }, m_Includes);
+		}
+
+		//Calls func(key, Val&...) for every key in the view
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			for (key_type const key : driver())
+			{
+				if (matches(key))
+				{
+					std::apply([&func, key](auto*... sets) { std::invoke(func, key, (*sets)[key]...); }, m_Includes);
+				}
+			}
+		}
+
+		//Returns a view that additionally excludes the keys of the given sets
+		template<typename... Others>
+		[[nodiscard]] sparse_view<get_t<Includes...>, exclude_t<Excludes..., Others...>> exclude(Others&... others) const noexcept
+		{
+			return std::apply([&](auto*... includes)
+				{
+					return std::apply([&](auto*... excludes)
+						{
+							return sparse_view<get_t<Includes...>, exclude_t<Excludes..., Others...>>{ *includes..., *excludes..., others... };
+						}, m_Excludes);
+				}, m_Includes);
+		}
+
+	private:
+		std::tuple<Includes*...> m_Includes;
+		std::tuple<Excludes*...> m_Excludes;
+
+		size_t m_DriverIdx{ 0 };
+
+		//Dense keys of the driver, looked up again every time since the sets may have grown since the last refresh
+		[[nodiscard]] std::span<const key_type> driver() const noexcept
+		{
+			std::span<const key_type> keys{ };
+			[this, &keys]<size_t... I>(std::index_sequence<I...>)
+			{
+				((I == m_DriverIdx ? (keys = std::get<I>(m_Includes)->dense(), void()) : void()), ...);
+			}(std::index_sequence_for<Includes...>{ });
+			return keys;
+		}
+
+		//Only for keys of the driver
+		[[nodiscard]] bool matches(key_type key) const noexcept
+		{
+			return [this, key]<size_t... I>(std::index_sequence<I...>)
+			{
+				//The driver contains the key by construction
+				return ((I == m_DriverIdx || std::get<I>(m_Includes)->contains(key)) && ...);
+			}(std::index_sequence_for<Includes...>{ })
+				&& std::apply([key](auto*... sets) { return !(sets->contains(key) || ...); }, m_Excludes);
+		}
+	};
+
+	//Builds a view over all keys that are in every given set, use exclude on the result to filter out keys of other sets.
+	template<typename... Sets>
+	[[nodiscard]] sparse_view<get_t<Sets...>> view(Sets&... sets) noexcept
+	{
+		return sparse_view<get_t<Sets...>>{ sets... };
+	}
+}
+
+#endif
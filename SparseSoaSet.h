@@ -0,0 +1,422 @@
+#ifndef SPARSE_SOA_SET
+#define SPARSE_SOA_SET
+
+#include <tuple>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <span>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	//Structure of arrays variant of sparse_set, one sparse and dense array shared by a packed array per column.
+	//Emplacing, erasing and sorting keep every column in lockstep, every column can be accessed as one contiguous span.
+	template<Impl::KeyType KeyType, Impl::SparsePolicy<KeyType> SparsePolicy, Impl::ValType... Ts>
+	class basic_sparse_soa_set final
+	{
+		static_assert(sizeof...(Ts) > 0, "A soa set needs at least one column");
+		static_assert((!std::is_same_v<Ts, bool> && ...), "bool columns are bit packed by std::vector, use uint8_t");
+
+	public:
+		template<bool IsConst>
+		class basic_iterator;
+
+		using key_type = KeyType;
+		using dense_type = KeyType;
+		using sparse_policy = SparsePolicy;
+		using sparse_storage = typename SparsePolicy::template storage_type<KeyType, dense_type>;
+
+		using reference = std::tuple<Ts&...>;
+		using const_reference = std::tuple<Ts const&...>;
+
+		using iterator = basic_iterator<false>;
+		using const_iterator = basic_iterator<true>;
+
+		static constexpr size_t column_count{ sizeof...(Ts) };
+
+		template<size_t Column>
+		using column_type = std::tuple_element_t<Column, std::tuple<Ts...>>;
+
+		basic_sparse_soa_set() noexcept = default;
+
+		basic_sparse_soa_set(KeyType sparseSize, KeyType reserveSize = 0) noexcept :
+			m_SparseArr(sparseSize)
+		{
+			reserve(reserveSize);
+		}
+
+		~basic_sparse_soa_set() noexcept = default;
+
+		basic_sparse_soa_set(const basic_sparse_soa_set&) noexcept = default;
+		basic_sparse_soa_set& operator=(const basic_sparse_soa_set&) noexcept = default;
+		basic_sparse_soa_set(basic_sparse_soa_set&&) noexcept = default;
+		basic_sparse_soa_set& operator=(basic_sparse_soa_set&&) noexcept = default;
+
+	public:
+		//Yields (key, column values...) tuples, the values are references into the columns
+		template<bool IsConst>
+		class basic_iterator final
+		{
+			using set_type = std::conditional_t<IsConst, const basic_sparse_soa_set, basic_sparse_soa_set>;
+
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = std::conditional_t<IsConst, std::tuple<KeyType, Ts const&...>, std::tuple<KeyType, Ts&...>>;
+			using reference = value_type;
+			using pointer = void;
+
+			basic_iterator() noexcept = default;
+			basic_iterator(set_type* set, size_t pos) noexcept :
+				m_Set{ set },
+				m_Pos{ pos }
+			{ }
+
+			[[nodiscard]] reference operator*() const noexcept { return m_Set->get_at(m_Pos); }
+			[[nodiscard]] reference operator[](difference_type offset) const noexcept { return m_Set->get_at(m_Pos + offset); }
+
+			basic_iterator& operator++() noexcept { ++m_Pos; return *this; }
+			basic_iterator operator++(int) noexcept { basic_iterator const temp{ *this }; ++m_Pos; return temp; }
+			basic_iterator& operator--() noexcept { --m_Pos; return *this; }
+			basic_iterator operator--(int) noexcept { basic_iterator const temp{ *this }; --m_Pos; return temp; }
+
+			basic_iterator& operator+=(difference_type offset) noexcept { m_Pos += offset; return *this; }
+			basic_iterator& operator-=(difference_type offset) noexcept { m_Pos -= offset; return *this; }
+			[[nodiscard]] basic_iterator operator+(difference_type offset) const noexcept { return basic_iterator{ m_Set, m_Pos + offset }; }
+			[[nodiscard]] friend basic_iterator operator+(difference_type offset, const basic_iterator& it) noexcept { return it + offset; }
+			[[nodiscard]] basic_iterator operator-(difference_type offset) const noexcept { return basic_iterator{ m_Set, m_Pos - offset }; }
+			[[nodiscard]] difference_type operator-(const basic_iterator& other) const noexcept
+			{
+				return static_cast<difference_type>(m_Pos) - static_cast<difference_type>(other.m_Pos);
+			}
+
+			[[nodiscard]] bool operator==(const basic_iterator& other) const noexcept { return m_Pos == other.m_Pos; }
+			[[nodiscard]] auto operator<=>(const basic_iterator& other) const noexcept { return m_Pos <=> other.m_Pos; }
+
+		private:
+			set_type* m_Set{ nullptr };
+			size_t m_Pos{ 0 };
+		};
+
+		iterator begin() noexcept { return iterator{ this, 0 }; }
+		iterator end() noexcept { return iterator{ this, m_DenseArr.size() }; }
+		const_iterator begin() const noexcept { return const_iterator{ this, 0 }; }
+		const_iterator end() const noexcept { return const_iterator{ this, m_DenseArr.size() }; }
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+	public:
+		[[nodiscard]] size_t size() const noexcept { return m_DenseArr.size(); }
+		[[nodiscard]] size_t sparse_size() const noexcept { return m_SparseArr.size(); }
+		[[nodiscard]] bool empty() const noexcept { return m_DenseArr.empty(); }
+
+		[[nodiscard]] static constexpr KeyType max_sparse_size() noexcept
+		{
+			return INVALID_INDEX - 1;
+		}
+
+		void resize(KeyType newSize, KeyType reserveSize = 0) noexcept
+		{
+			ASSERT(newSize > m_SparseArr.size(), "");
+
+			m_SparseArr.resize(newSize);
+			reserve(reserveSize);
+		}
+
+		void shrink_to_fit() noexcept
+		{
+			m_SparseArr.shrink_to_fit();
+			m_DenseArr.shrink_to_fit();
+			std::apply([](auto&... columns) { (columns.shrink_to_fit(), ...); }, m_Columns);
+		}
+
+		void sparse_reserve(KeyType newCap) noexcept
+		{
+			m_SparseArr.reserve(newCap);
+		}
+
+		void reserve(KeyType newCap) noexcept
+		{
+			m_DenseArr.reserve(newCap);
+			std::apply([newCap](auto&... columns) { (columns.reserve(newCap), ...); }, m_Columns);
+		}
+
+		void clear() noexcept
+		{
+			m_DenseArr.clear();
+			std::apply([](auto&... columns) { (columns.clear(), ...); }, m_Columns);
+			m_SparseArr.clear();
+		}
+
+		void swap(basic_sparse_soa_set& other) noexcept
+		{
+			std::swap(m_SparseArr, other.m_SparseArr);
+			std::swap(m_DenseArr, other.m_DenseArr);
+			std::swap(m_Columns, other.m_Columns);
+		}
+
+		const std::vector<KeyType>& dense() const noexcept { return m_DenseArr; }
+
+		//Contiguous values of one column, in dense order
+		template<size_t Column>
+		[[nodiscard]] std::span<column_type<Column>> column() noexcept { return std::get<Column>(m_Columns); }
+		template<size_t Column>
+		[[nodiscard]] std::span<column_type<Column> const> column() const noexcept { return std::get<Column>(m_Columns); }
+
+		//Only for column types that appear once
+		template<typename T>
+		[[nodiscard]] std::span<T> column() noexcept { return std::get<std::vector<T>>(m_Columns); }
+		template<typename T>
+		[[nodiscard]] std::span<T const> column() const noexcept { return std::get<std::vector<T>>(m_Columns); }
+
+	public:
+		[[nodiscard]] bool contains(KeyType element) const noexcept
+		{
+			ASSERT(element != INVALID_INDEX, "Element must be a valid index!");
+			return m_SparseArr.contains(element);
+		}
+
+		//Element must exist to get a valid value
+		[[nodiscard]] KeyType index(KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_SparseArr[element];
+		}
+
+		//Element must exist to get a valid value
+		reference operator[](KeyType element) noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return std::apply([index{ m_SparseArr[element] }](auto&... columns) { return reference{ columns[index]... }; }, m_Columns);
+		}
+		const_reference operator[](KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return std::apply([index{ m_SparseArr[element] }](auto const&... columns) { return const_reference{ columns[index]... }; }, m_Columns);
+		}
+
+		//Element must exist to get a valid value
+		template<size_t Column>
+		[[nodiscard]] column_type<Column>& get(KeyType element) noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return std::get<Column>(m_Columns)[m_SparseArr[element]];
+		}
+		template<size_t Column>
+		[[nodiscard]] column_type<Column> const& get(KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return std::get<Column>(m_Columns)[m_SparseArr[element]];
+		}
+
+		//Random access with bounds checking (similar to std::vector:::at())
+		const_reference at(KeyType element) const
+		{
+			if (contains(element))
+			{
+				return (*this)[element];
+			}
+			throw sparse_set_out_of_range("Element not found in sparse_soa_set", element);
+		}
+
+		iterator find(KeyType key) noexcept
+		{
+			return contains(key) ? iterator{ this, m_SparseArr[key] } : end();
+		}
+		const_iterator find(KeyType key) const noexcept
+		{
+			return contains(key) ? const_iterator{ this, m_SparseArr[key] } : end();
+		}
+
+	public:
+		//Takes one value per column, do not emplace the same element in the set twice, use try_emplace if this is a concern.
+		template<typename... Args>
+		requires (sizeof...(Args) == sizeof...(Ts)) && (std::is_constructible_v<Ts, Args> && ...)
+		reference emplace(KeyType element, Args&&... args) noexcept
+		{
+			ASSERT(!contains(element), "Element already in set!");
+
+			m_SparseArr.emplace(element, static_cast<KeyType>(m_DenseArr.size()));
+			m_DenseArr.emplace_back(element);
+
+			return [this]<size_t... I>(std::index_sequence<I...>, auto&&... values)
+			{
+				return reference{ std::get<I>(m_Columns).emplace_back(std::forward<decltype(values)>(values))... };
+			}(std::index_sequence_for<Ts...>{ }, std::forward<Args>(args)...);
+		}
+
+		template<typename... Args>
+		requires (sizeof...(Args) == sizeof...(Ts)) && (std::is_constructible_v<Ts, Args> && ...)
+		std::pair<iterator, bool> try_emplace(KeyType element, Args&&... args) noexcept
+		{
+			if (contains(element))
+			{
+				return { iterator{ this, m_SparseArr[element] }, false };
+			}
+
+			emplace(element, std::forward<Args>(args)...);
+			return { iterator{ this, m_SparseArr[element] }, true };
+		}
+
+		//Do not erase an element that does not exist, use remove instead if this is a concern.
+		//Swaps the last element into the hole and pops every column.
+		void erase(KeyType element) noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+
+			size_t const hole{ m_SparseArr[element] };
+			size_t const last{ m_DenseArr.size() - 1 };
+
+			if (hole != last)
+			{
+				std::apply([hole, last](auto&... columns) { (Impl::assign_value(columns[hole], std::move(columns[last])), ...); }, m_Columns);
+				m_DenseArr[hole] = m_DenseArr[last];
+				m_SparseArr[m_DenseArr[hole]] = static_cast<KeyType>(hole);
+			}
+
+			m_SparseArr.release(element);
+			m_DenseArr.pop_back();
+			std::apply([](auto&... columns) { (columns.pop_back(), ...); }, m_Columns);
+		}
+
+		bool remove(KeyType element) noexcept
+		{
+			return contains(element) && (erase(element), true);
+		}
+
+	public:
+		//Calls func(key, column values...) for every element
+		template<typename Func>
+		void each(Func&& func)
+		{
+			for (size_t i{ 0 }; i < m_DenseArr.size(); ++i)
+			{
+				std::apply([&func, key{ m_DenseArr[i] }, i](auto&... columns) { std::invoke(func, key, columns[i]...); }, m_Columns);
+			}
+		}
+		template<typename Func>
+		void each(Func&& func) const
+		{
+			for (size_t i{ 0 }; i < m_DenseArr.size(); ++i)
+			{
+				std::apply([&func, key{ m_DenseArr[i] }, i](auto const&... columns) { std::invoke(func, key, columns[i]...); }, m_Columns);
+			}
+		}
+
+		//Sorts all columns by the values of one column
+		template<size_t Column, Impl::Compare<column_type<Column>> Compare = std::less< >>
+		void sort(Compare&& compare = { })
+		{
+			auto const& values{ std::get<Column>(m_Columns) };
+			sort_indices([&values, &compare](size_t lhs, size_t rhs) { return std::invoke(compare, values[lhs], values[rhs]); });
+		}
+
+		//Sorts all columns by comparing the (column values...) references of two elements
+		template<typename Compare>
+		requires std::is_invocable_r_v<bool, Compare&, const_reference, const_reference>
+		void sort_by(Compare&& compare)
+		{
+			sort_indices([this, &compare](size_t lhs, size_t rhs) { return std::invoke(compare, get_values(lhs), get_values(rhs)); });
+		}
+
+		//Orders the elements by their key, after sorting dense() is ascending.
+		void sort_by_key()
+		{
+			sort_indices([this](size_t lhs, size_t rhs) { return m_DenseArr[lhs] < m_DenseArr[rhs]; });
+		}
+
+		template <size_t Column, Impl::Compare<column_type<Column>> Compare = std::less< >>
+		[[nodiscard]] bool is_sorted(Compare&& compare = { }) const noexcept
+		{
+			auto const& values{ std::get<Column>(m_Columns) };
+			return std::is_sorted(values.begin(), values.end(), std::forward<Compare>(compare));
+		}
+
+	private:
+		static constexpr KeyType INVALID_INDEX = std::numeric_limits<KeyType>::max();
+
+		sparse_storage m_SparseArr{ };
+
+		std::vector<KeyType> m_DenseArr{ };
+		std::tuple<std::vector<Ts>...> m_Columns{ };
+
+		std::vector<size_t> m_SortPerm{ };
+
+		template<typename Self>
+		[[nodiscard]] static auto get_at(Self* self, size_t pos) noexcept
+		{
+			ASSERT(pos < self->m_DenseArr.size(), "Position out of the set!");
+			return std::apply([key{ self->m_DenseArr[pos] }, pos](auto&... columns)
+				{
+					return std::tuple<KeyType, decltype(columns[pos])...>{ key, columns[pos]... };
+				}, self->m_Columns);
+		}
+		[[nodiscard]] auto get_at(size_t pos) noexcept { return get_at(this, pos); }
+		[[nodiscard]] auto get_at(size_t pos) const noexcept { return get_at(this, pos); }
+
+		[[nodiscard]] const_reference get_values(size_t pos) const noexcept
+		{
+			return std::apply([pos](auto const&... columns) { return const_reference{ columns[pos]... }; }, m_Columns);
+		}
+
+		//Sorts an index permutation with the compare and moves every column along its cycles
+		template<typename Compare>
+		void sort_indices(Compare&& compare)
+		{
+			size_t const count{ m_DenseArr.size() };
+
+			std::vector<size_t>& perm{ m_SortPerm };
+			perm.resize(count);
+			std::iota(perm.begin(), perm.end(), size_t{ });
+			std::sort(perm.begin(), perm.end(), compare);
+
+			for (size_t start{ 0 }; start < count; ++start)
+			{
+				if (perm[start] == start)
+				{
+					continue;
+				}
+
+				std::tuple<Ts...> temp{ std::apply([start](auto&... columns) { return std::tuple<Ts...>{ std::move(columns[start])... }; }, m_Columns) };
+				KeyType const tempKey{ m_DenseArr[start] };
+
+				size_t curr{ start };
+				size_t next{ perm[curr] };
+				while (next != start)
+				{
+					std::apply([curr, next](auto&... columns) { (Impl::assign_value(columns[curr], std::move(columns[next])), ...); }, m_Columns);
+					m_DenseArr[curr] = m_DenseArr[next];
+
+					perm[curr] = curr;
+					curr = next;
+					next = perm[curr];
+				}
+
+				[this, curr, &temp]<size_t... I>(std::index_sequence<I...>)
+				{
+					(Impl::assign_value(std::get<I>(m_Columns)[curr], std::move(std::get<I>(temp))), ...);
+				}(std::index_sequence_for<Ts...>{ });
+				m_DenseArr[curr] = tempKey;
+				perm[curr] = curr;
+			}
+
+			for (size_t i{ 0 }; i < count; ++i)
+			{
+				m_SparseArr[m_DenseArr[i]] = static_cast<KeyType>(i);
+			}
+		}
+	};
+
+	//Soa set with the default key type and sparse policy
+	template<Impl::ValType... Ts>
+	using sparse_soa_set = basic_sparse_soa_set<uint32_t, flat_sparse, Ts...>;
+}
+
+#endif
@@ -0,0 +1,1840 @@
+#ifndef SPARSE_STORAGE
+#define SPARSE_STORAGE
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <type_traits>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <concepts>
+
+#include <bit>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define SPARSE_STORAGE_SSE2
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+#include "InternalAssert.h"
+
+namespace Internal
+{
+	//Growth policies of the flat sparse array, decide how much capacity it reserves past the largest key and when it gives memory back.
+	//A TrimPercent above 0 enables automatic trimming: releasing the largest key drops the trailing invalid entries,
+	//and the capacity is released once less than TrimPercent percent of it is in use. clear() releases it the same way.
+
+	//Reserves exactly up to the largest key. Meant for key ranges that are reserved up front, growing key by key reallocates on every emplace.
+	template<size_t TrimPercent = 0>
+	struct exact_growth final
+	{
+		static_assert(TrimPercent < 100, "Trim threshold must be below 100 percent");
+		static constexpr size_t TRIM_PERCENT{ TrimPercent };
+
+		[[nodiscard]] static constexpr size_t grow(size_t, size_t required) noexcept
+		{
+			return required;
+		}
+	};
+
+	//Grows the capacity by Numerator / Denominator (default), emplacing increasing keys stays amortized constant.
+	template<size_t Numerator = 3, size_t Denominator = 2, size_t TrimPercent = 0>
+	struct geometric_growth final
+	{
+		static_assert(Denominator > 0 && Numerator > Denominator, "Growth factor must be above 1");
+		static_assert(TrimPercent < 100, "Trim threshold must be below 100 percent");
+		static constexpr size_t TRIM_PERCENT{ TrimPercent };
+
+		[[nodiscard]] static constexpr size_t grow(size_t capacity, size_t required) noexcept
+		{
+			return std::max(required, capacity + capacity / Denominator * (Numerator - Denominator));
+		}
+	};
+
+	//Rounds the capacity up to whole pages of PageSize entries, the slack stays below one page.
+	//Reallocates once per page of new keys, so pick a page size that matches how far the keys grow at once.
+	template<size_t PageSize = 4096, size_t TrimPercent = 0>
+	struct page_growth final
+	{
+		static_assert(PageSize > 0, "Page size must not be 0");
+		static_assert(TrimPercent < 100, "Trim threshold must be below 100 percent");
+		static constexpr size_t TRIM_PERCENT{ TrimPercent };
+
+		[[nodiscard]] static constexpr size_t grow(size_t, size_t required) noexcept
+		{
+			return (required + PageSize - 1) / PageSize * PageSize;
+		}
+	};
+
+	namespace Impl
+	{
+		template<typename G>
+		concept GrowthPolicy = requires(size_t capacity, size_t required)
+		{
+			{ G::TRIM_PERCENT } -> std::convertible_to<size_t>;
+			{ G::grow(capacity, required) } -> std::convertible_to<size_t>;
+		};
+
+		//Maps keys directly onto a contiguous array, the array grows up to the largest key that was emplaced.
+		//Growth decides the reserved capacity and whether the array trims itself, see geometric_growth.
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>, GrowthPolicy Growth = geometric_growth<>>
+		class flat_sparse_storage final
+		{
+		public:
+			using key_type = KeyType;
+			using dense_type = DenseType;
+			using allocator_type = Allocator;
+			using container_type = std::vector<DenseType, Allocator>;
+			using growth_policy = Growth;
+
+			static constexpr DenseType INVALID_INDEX = std::numeric_limits<DenseType>::max();
+
+			flat_sparse_storage() noexcept = default;
+			explicit flat_sparse_storage(const Allocator& alloc) noexcept :
+				m_Arr(alloc)
+			{ }
+			explicit flat_sparse_storage(size_t size, const Allocator& alloc = Allocator{ }) noexcept :
+				m_Arr(size, INVALID_INDEX, alloc)
+			{ }
+
+		public:
+			[[nodiscard]] bool contains(KeyType key) const noexcept
+			{
+				return key < m_Arr.size() && m_Arr[key] != INVALID_INDEX;
+			}
+
+			//Returns INVALID_INDEX when the key is not in the storage
+			[[nodiscard]] DenseType get(KeyType key) const noexcept
+			{
+				return key < m_Arr.size() ? m_Arr[key] : INVALID_INDEX;
+			}
+
+			//Batched get, gathers the dense index of every key (INVALID_INDEX when not in the storage).
+			//Uses AVX-512 / AVX2 gathers when the keys and indices are 32 or 64 bit wide, the scalar loop handles the rest.
+			void get_many(const KeyType* keys, size_t count, DenseType* out) const noexcept
+			{
+				size_t i{ 0 };
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+				//Gathers use signed offsets, larger arrays take the scalar path
+				if constexpr (sizeof(KeyType) == sizeof(DenseType) && (sizeof(KeyType) == 4 || sizeof(KeyType) == 8))
+				{
+					if (!m_Arr.empty() && m_Arr.size() <= static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+					{
+						i = gather_many(keys, count, out);
+					}
+				}
+#endif
+
+				for (; i < count; ++i)
+				{
+					out[i] = get(keys[i]);
+				}
+			}
+
+			//Key must be in the storage
+			DenseType& operator[](KeyType key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return m_Arr[key];
+			}
+			DenseType const& operator[](KeyType key) const noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return m_Arr[key];
+			}
+
+			void emplace(KeyType key, DenseType index) noexcept
+			{
+				ASSERT(index != INVALID_INDEX, "Index must be valid!");
+
+				if (key >= m_Arr.size())
+				{
+					grow(static_cast<size_t>(key) + 1);
+				}
+				m_Arr[key] = index;
+			}
+
+			void release(KeyType key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				m_Arr[key] = INVALID_INDEX;
+
+				if constexpr (Growth::TRIM_PERCENT > 0)
+				{
+					if (static_cast<size_t>(key) + 1 == m_Arr.size())
+					{
+						drop_trailing();
+						release_unused();
+					}
+				}
+			}
+
+		public:
+			[[nodiscard]] size_t size() const noexcept { return m_Arr.size(); }
+
+			[[nodiscard]] size_t capacity() const noexcept { return m_Arr.capacity(); }
+
+			//Bytes allocated for the entries
+			[[nodiscard]] size_t memory_usage() const noexcept { return m_Arr.capacity() * sizeof(DenseType); }
+
+			void resize(size_t newSize) noexcept
+			{
+				if (newSize > m_Arr.size())
+				{
+					grow(newSize);
+				}
+				m_Arr.resize(newSize, INVALID_INDEX);
+			}
+
+			void reserve(size_t newCap) noexcept
+			{
+				m_Arr.reserve(newCap);
+			}
+
+			//Drops the invalid entries behind the largest key before releasing the unused capacity
+			void shrink_to_fit() noexcept
+			{
+				drop_trailing();
+				m_Arr.shrink_to_fit();
+			}
+
+			void clear() noexcept
+			{
+				m_Arr.clear();
+
+				if constexpr (Growth::TRIM_PERCENT > 0)
+				{
+					release_unused();
+				}
+			}
+
+			const container_type& data() const noexcept { return m_Arr; }
+			//Raw access for snapshot loading, every entry must be a valid dense index or INVALID_INDEX
+			container_type& data() noexcept { return m_Arr; }
+
+			[[nodiscard]] allocator_type get_allocator() const noexcept { return m_Arr.get_allocator(); }
+
+		private:
+			container_type m_Arr{ };
+
+			//Grows the array to newSize entries, the capacity it reserves on the way is up to the growth policy
+			void grow(size_t newSize) noexcept
+			{
+				if (newSize > m_Arr.capacity())
+				{
+					m_Arr.reserve(std::clamp(Growth::grow(m_Arr.capacity(), newSize), newSize, std::max(newSize, m_Arr.max_size())));
+				}
+				m_Arr.resize(newSize, INVALID_INDEX);
+			}
+
+			//Every entry is dropped at most once after it was grown, so trimming on release stays amortized constant
+			void drop_trailing() noexcept
+			{
+				auto const last{ std::find_if(m_Arr.rbegin(), m_Arr.rend(), [](DenseType index) { return index != INVALID_INDEX; }) };
+				m_Arr.erase(last.base(), m_Arr.end());
+			}
+
+			void release_unused() noexcept
+			{
+				if (m_Arr.size() * 100 < m_Arr.capacity() * Growth::TRIM_PERCENT)
+				{
+					m_Arr.shrink_to_fit();
+				}
+			}
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+			//Returns the amount of keys that were handled, out of bounds lanes are masked off and keep INVALID_INDEX
+			size_t gather_many(const KeyType* keys, size_t count, DenseType* out) const noexcept
+			{
+				size_t i{ 0 };
+
+				if constexpr (sizeof(KeyType) == 4)
+				{
+					auto const* base{ reinterpret_cast<const int*>(m_Arr.data()) };
+	#if defined(__AVX512F__)
+					__m512i const size{ _mm512_set1_epi32(static_cast<int>(m_Arr.size())) };
+					__m512i const invalid{ _mm512_set1_epi32(-1) };
+					for (; i + 16 <= count; i += 16)
+					{
+						__m512i const k{ _mm512_loadu_si512(keys + i) };
+						__mmask16 const inBounds{ _mm512_cmplt_epu32_mask(k, size) };
+						_mm512_storeu_si512(out + i, _mm512_mask_i32gather_epi32(invalid, inBounds, k, base, 4));
+					}
+	#else
+					__m256i const last{ _mm256_set1_epi32(static_cast<int>(m_Arr.size() - 1)) };
+					__m256i const invalid{ _mm256_set1_epi32(-1) };
+					for (; i + 8 <= count; i += 8)
+					{
+						__m256i const k{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)) };
+						__m256i const inBounds{ _mm256_cmpeq_epi32(_mm256_min_epu32(k, last), k) };
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mask_i32gather_epi32(invalid, base, k, inBounds, 4));
+					}
+	#endif
+				}
+				else
+				{
+					auto const* base{ reinterpret_cast<const long long*>(m_Arr.data()) };
+	#if defined(__AVX512F__)
+					__m512i const size{ _mm512_set1_epi64(static_cast<long long>(m_Arr.size())) };
+					__m512i const invalid{ _mm512_set1_epi64(-1) };
+					for (; i + 8 <= count; i += 8)
+					{
+						__m512i const k{ _mm512_loadu_si512(keys + i) };
+						__mmask8 const inBounds{ _mm512_cmplt_epu64_mask(k, size) };
+						_mm512_storeu_si512(out + i, _mm512_mask_i64gather_epi64(invalid, inBounds, k, base, 8));
+					}
+	#else
+					//No unsigned 64 bit compare in AVX2, flip the sign bit and compare signed instead
+					__m256i const sign{ _mm256_set1_epi64x(std::numeric_limits<long long>::min()) };
+					__m256i const size{ _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(m_Arr.size())), sign) };
+					__m256i const invalid{ _mm256_set1_epi64x(-1) };
+					for (; i + 4 <= count; i += 4)
+					{
+						__m256i const k{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)) };
+						__m256i const inBounds{ _mm256_cmpgt_epi64(size, _mm256_xor_si256(k, sign)) };
+						_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mask_i64gather_epi64(invalid, base, k, inBounds, 8));
+					}
+	#endif
+				}
+
+				return i;
+			}
+#endif
+		};
+
+		template<typename KeyType, typename DenseType, typename Allocator>
+		class hashed_sparse_storage;
+
+		//Splits the key space into fixed size pages that are only allocated once a key in their range is emplaced,
+		//and released again once their last key is released. Pages are found through a directory of blocks of BLOCK_PAGES pages,
+		//a block is allocated with its first page and freed with its last one. Key types with few blocks index them directly
+		//(a directory of at most 64K entries), wider key types find them through a hashed index, so memory scales with the live keys.
+		//Pages come from the allocator, blocks and the directory from rebinds of it.
+		template<typename KeyType, typename DenseType, size_t PageSize, typename Allocator = std::allocator<DenseType>>
+		class paged_sparse_storage final
+		{
+			static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0, "Page size must be a power of two");
+			static_assert(PageSize <= std::numeric_limits<uint32_t>::max(), "Page size must fit the per page counters");
+
+			using alloc_traits = std::allocator_traits<Allocator>;
+			using page_pointer = typename alloc_traits::pointer;
+
+			static constexpr size_t BLOCK_PAGES{ 256 };
+			static constexpr uint64_t BLOCK_KEYS{ uint64_t{ PageSize } * BLOCK_PAGES };
+			static constexpr bool DIRECT_DIRECTORY{ std::numeric_limits<KeyType>::max() / BLOCK_KEYS < 65536 };
+
+			struct page_block final
+			{
+				std::array<page_pointer, BLOCK_PAGES> pages{ };
+				std::array<uint32_t, BLOCK_PAGES> counts{ };
+				size_t pageCount{ 0 };
+				size_t id{ 0 };
+			};
+
+			using block_alloc = typename alloc_traits::template rebind_alloc<page_block>;
+			using block_traits = std::allocator_traits<block_alloc>;
+			using block_pointer = typename block_traits::pointer;
+			using block_table = std::vector<block_pointer, typename alloc_traits::template rebind_alloc<block_pointer>>;
+
+			//Block id to slot in the block table, only wide key types need it
+			struct direct_index final { };
+			using hashed_index = hashed_sparse_storage<KeyType, uint32_t, typename alloc_traits::template rebind_alloc<uint32_t>>;
+			using block_index = std::conditional_t<DIRECT_DIRECTORY, direct_index, hashed_index>;
+
+		public:
+			using key_type = KeyType;
+			using dense_type = DenseType;
+			using allocator_type = Allocator;
+
+			static constexpr DenseType INVALID_INDEX = std::numeric_limits<DenseType>::max();
+
+			paged_sparse_storage() noexcept = default;
+			explicit paged_sparse_storage(const Allocator& alloc) noexcept :
+				m_Alloc{ alloc },
+				m_Blocks(typename block_table::allocator_type{ alloc }),
+				m_Index{ make_index(alloc) }
+			{ }
+			explicit paged_sparse_storage(size_t size, const Allocator& alloc = Allocator{ }) noexcept :
+				paged_sparse_storage{ alloc }
+			{
+				resize(size);
+			}
+
+			~paged_sparse_storage() noexcept
+			{
+				release_pages();
+			}
+
+			paged_sparse_storage(const paged_sparse_storage& other) noexcept :
+				paged_sparse_storage{ alloc_traits::select_on_container_copy_construction(other.m_Alloc) }
+			{
+				copy_pages(other);
+			}
+
+			paged_sparse_storage& operator=(const paged_sparse_storage& other) noexcept
+			{
+				if (this != &other)
+				{
+					release_pages();
+					if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+					{
+						rebind_tables(other.m_Alloc);
+					}
+					copy_pages(other);
+				}
+
+				return *this;
+			}
+
+			paged_sparse_storage(paged_sparse_storage&& other) noexcept :
+				m_Alloc{ std::move(other.m_Alloc) },
+				m_Blocks{ std::move(other.m_Blocks) },
+				m_Index{ std::move(other.m_Index) },
+				m_PageCount{ std::exchange(other.m_PageCount, 0) },
+				m_BlockCount{ std::exchange(other.m_BlockCount, 0) },
+				m_PageLimit{ std::exchange(other.m_PageLimit, 0) }
+			{
+				other.m_Blocks.clear();
+			}
+
+			//Pages can only be taken over when they can be freed with this allocator, otherwise they are copied
+			paged_sparse_storage& operator=(paged_sparse_storage&& other) noexcept
+			{
+				if (this == &other)
+				{
+					return *this;
+				}
+
+				if constexpr (!alloc_traits::propagate_on_container_move_assignment::value && !alloc_traits::is_always_equal::value)
+				{
+					if (m_Alloc != other.m_Alloc)
+					{
+						release_pages();
+						copy_pages(other);
+						return *this;
+					}
+				}
+
+				release_pages();
+				if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+				{
+					m_Alloc = std::move(other.m_Alloc);
+				}
+				m_Blocks = std::move(other.m_Blocks);
+				m_Index = std::move(other.m_Index);
+				m_PageCount = std::exchange(other.m_PageCount, 0);
+				m_BlockCount = std::exchange(other.m_BlockCount, 0);
+				m_PageLimit = std::exchange(other.m_PageLimit, 0);
+				other.m_Blocks.clear();
+
+				return *this;
+			}
+
+		public:
+			[[nodiscard]] bool contains(KeyType key) const noexcept
+			{
+				page_pointer const page{ find_page(key) };
+				return page && page[page_offset(key)] != INVALID_INDEX;
+			}
+
+			//Returns INVALID_INDEX when the key is not in the storage
+			[[nodiscard]] DenseType get(KeyType key) const noexcept
+			{
+				page_pointer const page{ find_page(key) };
+				return page ? page[page_offset(key)] : INVALID_INDEX;
+			}
+
+			//Batched get, gathers the dense index of every key (INVALID_INDEX when not in the storage)
+			void get_many(const KeyType* keys, size_t count, DenseType* out) const noexcept
+			{
+				for (size_t i{ 0 }; i < count; ++i)
+				{
+					out[i] = get(keys[i]);
+				}
+			}
+
+			//Key must be in the storage
+			DenseType& operator[](KeyType key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return find_page(key)[page_offset(key)];
+			}
+			DenseType const& operator[](KeyType key) const noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return find_page(key)[page_offset(key)];
+			}
+
+			void emplace(KeyType key, DenseType index) noexcept
+			{
+				ASSERT(index != INVALID_INDEX, "Index must be valid!");
+
+				m_PageLimit = std::max(m_PageLimit, page_index(key) + 1);
+
+				page_block& block{ get_or_create_block(block_id(key)) };
+				size_t const slot{ block_slot(key) };
+				if (!block.pages[slot])
+				{
+					block.pages[slot] = allocate_page();
+					std::fill_n(block.pages[slot], PageSize, INVALID_INDEX);
+					++block.pageCount;
+					++m_PageCount;
+				}
+
+				DenseType& entry{ block.pages[slot][page_offset(key)] };
+				if (entry == INVALID_INDEX)
+				{
+					++block.counts[slot];
+				}
+				entry = index;
+			}
+
+			void release(KeyType key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+
+				page_block& block{ *find_block(block_id(key)) };
+				size_t const slot{ block_slot(key) };
+				block.pages[slot][page_offset(key)] = INVALID_INDEX;
+
+				if (--block.counts[slot] == 0)
+				{
+					alloc_traits::deallocate(m_Alloc, block.pages[slot], PageSize);
+					block.pages[slot] = nullptr;
+					--m_PageCount;
+
+					if (--block.pageCount == 0)
+					{
+						free_block(block.id);
+					}
+				}
+			}
+
+		public:
+			//Number of keys up to the largest page that was addressed, keys need no address space beyond the directory
+			[[nodiscard]] size_t size() const noexcept
+			{
+				return m_PageLimit > std::numeric_limits<size_t>::max() / PageSize ? std::numeric_limits<size_t>::max() : m_PageLimit * PageSize;
+			}
+
+			[[nodiscard]] size_t page_count() const noexcept { return m_PageCount; }
+
+			[[nodiscard]] static constexpr size_t page_size() noexcept { return PageSize; }
+
+			//Bytes of the allocated pages, blocks and the directory
+			[[nodiscard]] size_t memory_usage() const noexcept
+			{
+				size_t bytes{ m_PageCount * PageSize * sizeof(DenseType) + m_BlockCount * sizeof(page_block) + m_Blocks.capacity() * sizeof(block_pointer) };
+				if constexpr (!DIRECT_DIRECTORY)
+				{
+					bytes += m_Index.memory_usage();
+				}
+				return bytes;
+			}
+
+			//Only raises the addressed range, pages and blocks are still allocated lazily
+			void resize(size_t newSize) noexcept
+			{
+				m_PageLimit = std::max(m_PageLimit, newSize / PageSize + (newSize % PageSize != 0 ? size_t{ 1 } : size_t{ 0 }));
+			}
+
+			void reserve(size_t newCap) noexcept
+			{
+				if constexpr (DIRECT_DIRECTORY)
+				{
+					m_Blocks.reserve(static_cast<size_t>((newCap + BLOCK_KEYS - 1) / BLOCK_KEYS));
+				}
+			}
+
+			//Drops the directory entries behind the last block and recomputes the addressed range from the live pages
+			void shrink_to_fit() noexcept
+			{
+				if constexpr (DIRECT_DIRECTORY)
+				{
+					while (!m_Blocks.empty() && !m_Blocks.back())
+					{
+						m_Blocks.pop_back();
+					}
+				}
+				else
+				{
+					m_Index.shrink_to_fit();
+				}
+				m_Blocks.shrink_to_fit();
+
+				m_PageLimit = 0;
+				for_each_block([this](page_block& block)
+					{
+						for (size_t slot{ BLOCK_PAGES }; slot > 0; --slot)
+						{
+							if (block.pages[slot - 1])
+							{
+								m_PageLimit = std::max(m_PageLimit, block.id * BLOCK_PAGES + slot);
+								break;
+							}
+						}
+					});
+			}
+
+			void clear() noexcept
+			{
+				release_pages();
+			}
+
+			[[nodiscard]] allocator_type get_allocator() const noexcept { return m_Alloc; }
+
+		private:
+			static constexpr uint32_t NO_BLOCK{ std::numeric_limits<uint32_t>::max() };
+
+			Allocator m_Alloc{ };
+			block_table m_Blocks{ };
+			block_index m_Index{ };
+			size_t m_PageCount{ 0 };
+			size_t m_BlockCount{ 0 };
+			//Pages up to the largest addressed one, see size
+			size_t m_PageLimit{ 0 };
+
+			[[nodiscard]] static constexpr size_t page_index(KeyType key) noexcept
+			{
+				return static_cast<size_t>(key) / PageSize;
+			}
+			[[nodiscard]] static constexpr size_t page_offset(KeyType key) noexcept
+			{
+				return static_cast<size_t>(key) & (PageSize - 1);
+			}
+			[[nodiscard]] static constexpr size_t block_id(KeyType key) noexcept
+			{
+				return page_index(key) / BLOCK_PAGES;
+			}
+			[[nodiscard]] static constexpr size_t block_slot(KeyType key) noexcept
+			{
+				return page_index(key) & (BLOCK_PAGES - 1);
+			}
+
+			[[nodiscard]] static block_index make_index([[maybe_unused]] const Allocator& alloc) noexcept
+			{
+				if constexpr (DIRECT_DIRECTORY)
+				{
+					return { };
+				}
+				else
+				{
+					return block_index{ typename block_index::allocator_type{ alloc } };
+				}
+			}
+
+			[[nodiscard]] page_block* find_block(size_t id) const noexcept
+			{
+				if constexpr (DIRECT_DIRECTORY)
+				{
+					return id < m_Blocks.size() ? std::to_address(m_Blocks[id]) : nullptr;
+				}
+				else
+				{
+					uint32_t const slot{ m_Index.get(static_cast<KeyType>(id)) };
+					return slot != NO_BLOCK ? std::to_address(m_Blocks[slot]) : nullptr;
+				}
+			}
+
+			[[nodiscard]] page_pointer find_page(KeyType key) const noexcept
+			{
+				page_block const* const block{ find_block(block_id(key)) };
+				return block ? block->pages[block_slot(key)] : nullptr;
+			}
+
+			page_block& get_or_create_block(size_t id) noexcept
+			{
+				if constexpr (DIRECT_DIRECTORY)
+				{
+					if (id >= m_Blocks.size())
+					{
+						m_Blocks.resize(id + 1, nullptr);
+					}
+					if (!m_Blocks[id])
+					{
+						m_Blocks[id] = allocate_block(id);
+					}
+					return *m_Blocks[id];
+				}
+				else
+				{
+					uint32_t const slot{ m_Index.get(static_cast<KeyType>(id)) };
+					if (slot != NO_BLOCK)
+					{
+						return *m_Blocks[slot];
+					}
+
+					ASSERT(m_Blocks.size() < NO_BLOCK, "Too many page blocks!");
+					m_Index.emplace(static_cast<KeyType>(id), static_cast<uint32_t>(m_Blocks.size()));
+					return *m_Blocks.emplace_back(allocate_block(id));
+				}
+			}
+
+			//Frees an empty block, the hashed directory fills the slot with its last block
+			void free_block(size_t id) noexcept
+			{
+				if constexpr (DIRECT_DIRECTORY)
+				{
+					deallocate_block(m_Blocks[id]);
+					m_Blocks[id] = nullptr;
+				}
+				else
+				{
+					uint32_t const slot{ m_Index.get(static_cast<KeyType>(id)) };
+					deallocate_block(m_Blocks[slot]);
+					m_Index.release(static_cast<KeyType>(id));
+
+					if (slot + size_t{ 1 } != m_Blocks.size())
+					{
+						m_Blocks[slot] = m_Blocks.back();
+						m_Index[static_cast<KeyType>(m_Blocks[slot]->id)] = slot;
+					}
+					m_Blocks.pop_back();
+				}
+			}
+
+			[[nodiscard]] page_pointer allocate_page() noexcept
+			{
+				return alloc_traits::allocate(m_Alloc, PageSize);
+			}
+
+			[[nodiscard]] block_pointer allocate_block(size_t id) noexcept
+			{
+				block_alloc alloc{ m_Alloc };
+				block_pointer const block{ block_traits::allocate(alloc, 1) };
+				block_traits::construct(alloc, std::to_address(block));
+				block->id = id;
+				++m_BlockCount;
+				return block;
+			}
+
+			void deallocate_block(block_pointer block) noexcept
+			{
+				block_alloc alloc{ m_Alloc };
+				block_traits::destroy(alloc, std::to_address(block));
+				block_traits::deallocate(alloc, block, 1);
+				--m_BlockCount;
+			}
+
+			template<typename Func>
+			void for_each_block(Func&& func) const
+			{
+				for (block_pointer const& block : m_Blocks)
+				{
+					if (block)
+					{
+						func(*block);
+					}
+				}
+			}
+
+			//Frees every page and block and empties the directory, the directory keeps its capacity
+			void release_pages() noexcept
+			{
+				for_each_block([this](page_block& block)
+					{
+						for (page_pointer const page : block.pages)
+						{
+							if (page)
+							{
+								alloc_traits::deallocate(m_Alloc, page, PageSize);
+							}
+						}
+					});
+				for (block_pointer const block : m_Blocks)
+				{
+					if (block)
+					{
+						deallocate_block(block);
+					}
+				}
+
+				m_Blocks.clear();
+				if constexpr (!DIRECT_DIRECTORY)
+				{
+					m_Index.clear();
+				}
+				m_PageCount = 0;
+				m_PageLimit = 0;
+			}
+
+			//Switches to a new allocator, the directory must be empty
+			void rebind_tables(const Allocator& alloc) noexcept
+			{
+				m_Alloc = alloc;
+				m_Blocks = block_table(typename block_table::allocator_type{ alloc });
+				m_Index = make_index(alloc);
+			}
+
+			//The directory must be empty
+			void copy_pages(const paged_sparse_storage& other) noexcept
+			{
+				other.for_each_block([this](const page_block& source)
+					{
+						page_block& block{ get_or_create_block(source.id) };
+						block.counts = source.counts;
+						block.pageCount = source.pageCount;
+
+						for (size_t slot{ 0 }; slot < BLOCK_PAGES; ++slot)
+						{
+							if (source.pages[slot])
+							{
+								block.pages[slot] = allocate_page();
+								std::copy_n(source.pages[slot], PageSize, block.pages[slot]);
+							}
+						}
+					});
+
+				m_PageCount = other.m_PageCount;
+				m_PageLimit = other.m_PageLimit;
+			}
+		};
+
+		//Open addressing hash table from key to dense index, memory scales with the live keys no matter how they are spread.
+		//Slots are probed in groups of 16 with one control byte per slot (SSE2 compares a whole group at once):
+		//the low 7 bits of the hash for a full slot, EMPTY or DELETED otherwise. Groups are probed triangularly.
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>>
+		class hashed_sparse_storage final
+		{
+			using alloc_traits = std::allocator_traits<Allocator>;
+
+			struct slot_type final
+			{
+				KeyType key;
+				DenseType index;
+			};
+
+			using ctrl_container = std::vector<int8_t, typename alloc_traits::template rebind_alloc<int8_t>>;
+			using slot_container = std::vector<slot_type, typename alloc_traits::template rebind_alloc<slot_type>>;
+
+		public:
+			using key_type = KeyType;
+			using dense_type = DenseType;
+			using allocator_type = Allocator;
+
+			static constexpr DenseType INVALID_INDEX = std::numeric_limits<DenseType>::max();
+
+			hashed_sparse_storage() noexcept = default;
+			explicit hashed_sparse_storage(const Allocator& alloc) noexcept :
+				m_Ctrl(typename ctrl_container::allocator_type{ alloc }),
+				m_Slots(typename slot_container::allocator_type{ alloc })
+			{ }
+			//Keys need no address space, size is ignored
+			explicit hashed_sparse_storage(size_t, const Allocator& alloc = Allocator{ }) noexcept :
+				hashed_sparse_storage{ alloc }
+			{ }
+
+			~hashed_sparse_storage() noexcept = default;
+
+			hashed_sparse_storage(const hashed_sparse_storage&) noexcept = default;
+			hashed_sparse_storage& operator=(const hashed_sparse_storage&) noexcept = default;
+
+			hashed_sparse_storage(hashed_sparse_storage&& other) noexcept :
+				m_Ctrl{ std::move(other.m_Ctrl) },
+				m_Slots{ std::move(other.m_Slots) },
+				m_Count{ std::exchange(other.m_Count, 0) },
+				m_Deleted{ std::exchange(other.m_Deleted, 0) }
+			{
+				other.m_Ctrl.clear();
+				other.m_Slots.clear();
+			}
+
+			hashed_sparse_storage& operator=(hashed_sparse_storage&& other) noexcept
+			{
+				if (this != &other)
+				{
+					m_Ctrl = std::move(other.m_Ctrl);
+					m_Slots = std::move(other.m_Slots);
+					m_Count = std::exchange(other.m_Count, 0);
+					m_Deleted = std::exchange(other.m_Deleted, 0);
+					other.m_Ctrl.clear();
+					other.m_Slots.clear();
+				}
+
+				return *this;
+			}
+
+		public:
+			[[nodiscard]] bool contains(KeyType key) const noexcept
+			{
+				return find(key) != NOT_FOUND;
+			}
+
+			//Returns INVALID_INDEX when the key is not in the storage
+			[[nodiscard]] DenseType get(KeyType key) const noexcept
+			{
+				size_t const slot{ find(key) };
+				return slot != NOT_FOUND ? m_Slots[slot].index : INVALID_INDEX;
+			}
+
+			//Batched get, prefetches the control group of the key a few lookups ahead to overlap the cache misses
+			void get_many(const KeyType* keys, size_t count, DenseType* out) const noexcept
+			{
+				for (size_t i{ 0 }; i < count; ++i)
+				{
+#if defined(SPARSE_STORAGE_SSE2)
+					if (i + PREFETCH_DISTANCE < count && !m_Ctrl.empty())
+					{
+						size_t const group{ static_cast<size_t>(hash(keys[i + PREFETCH_DISTANCE]) >> 7) & group_mask() };
+						_mm_prefetch(reinterpret_cast<const char*>(m_Ctrl.data() + group * GROUP_SIZE), _MM_HINT_T0);
+					}
+#endif
+					out[i] = get(keys[i]);
+				}
+			}
+
+			//Key must be in the storage
+			DenseType& operator[](KeyType key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return m_Slots[find(key)].index;
+			}
+			DenseType const& operator[](KeyType key) const noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return m_Slots[find(key)].index;
+			}
+
+			void emplace(KeyType key, DenseType index) noexcept
+			{
+				ASSERT(index != INVALID_INDEX, "Index must be valid!");
+
+				if (size_t const slot{ find(key) }; slot != NOT_FOUND)
+				{
+					m_Slots[slot].index = index;
+					return;
+				}
+
+				//Tombstones count against the load, a rehash drops them
+				if ((m_Count + m_Deleted + 1) * 8 > capacity() * 7)
+				{
+					rehash(std::max(capacity(), capacity_for((m_Count + 1) * 2)));
+				}
+				insert_new(key, index);
+			}
+
+			void release(KeyType key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+
+				size_t const slot{ find(key) };
+
+				//A group with an empty slot ends every probe that reaches it, so no probe passes through it and the slot can be empty again
+				if (match_byte(m_Ctrl.data() + (slot & ~(GROUP_SIZE - 1)), EMPTY) != 0)
+				{
+					m_Ctrl[slot] = EMPTY;
+				}
+				else
+				{
+					m_Ctrl[slot] = DELETED;
+					++m_Deleted;
+				}
+				--m_Count;
+			}
+
+			//Calls func(key, index) for every key in slot order
+			template<typename Func>
+			void each(Func&& func) const
+			{
+				for (size_t slot{ 0 }; slot < m_Slots.size(); ++slot)
+				{
+					if (m_Ctrl[slot] >= 0)
+					{
+						func(m_Slots[slot].key, m_Slots[slot].index);
+					}
+				}
+			}
+
+		public:
+			//Number of slots, keys need no address space
+			[[nodiscard]] size_t size() const noexcept { return capacity(); }
+			[[nodiscard]] size_t capacity() const noexcept { return m_Slots.size(); }
+
+			//Number of keys in the storage
+			[[nodiscard]] size_t count() const noexcept { return m_Count; }
+
+			//Bytes of the control bytes and slots
+			[[nodiscard]] size_t memory_usage() const noexcept { return m_Ctrl.capacity() * sizeof(int8_t) + m_Slots.capacity() * sizeof(slot_type); }
+
+			//Keys need no address space, nothing to resize
+			void resize(size_t) noexcept { }
+
+			//Makes room for newCap keys without rehashing
+			void reserve(size_t newCap) noexcept
+			{
+				if (newCap * 8 > capacity() * 7)
+				{
+					rehash(capacity_for(newCap));
+				}
+			}
+
+			void shrink_to_fit() noexcept
+			{
+				if (m_Count == 0)
+				{
+					m_Ctrl = ctrl_container(m_Ctrl.get_allocator());
+					m_Slots = slot_container(m_Slots.get_allocator());
+					m_Deleted = 0;
+				}
+				else if (capacity_for(m_Count) < capacity())
+				{
+					rehash(capacity_for(m_Count));
+				}
+			}
+
+			void clear() noexcept
+			{
+				std::fill(m_Ctrl.begin(), m_Ctrl.end(), EMPTY);
+				m_Count = 0;
+				m_Deleted = 0;
+			}
+
+			[[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_type{ m_Slots.get_allocator() }; }
+
+		private:
+			static constexpr size_t GROUP_SIZE{ 16 };
+			static constexpr size_t PREFETCH_DISTANCE{ 8 };
+			static constexpr size_t NOT_FOUND{ std::numeric_limits<size_t>::max() };
+
+			static constexpr int8_t EMPTY{ -128 };
+			static constexpr int8_t DELETED{ -2 };
+
+			ctrl_container m_Ctrl{ };
+			slot_container m_Slots{ };
+
+			size_t m_Count{ 0 };
+			size_t m_Deleted{ 0 };
+
+			[[nodiscard]] static constexpr uint64_t hash(KeyType key) noexcept
+			{
+				uint64_t const h{ static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull };
+				return h ^ (h >> 32);
+			}
+
+			[[nodiscard]] static constexpr int8_t tag(uint64_t h) noexcept
+			{
+				return static_cast<int8_t>(h & 0x7F);
+			}
+
+			[[nodiscard]] size_t group_mask() const noexcept
+			{
+				return m_Slots.size() / GROUP_SIZE - 1;
+			}
+
+			//Smallest power of two capacity that keeps count keys under the max load of 7/8
+			[[nodiscard]] static size_t capacity_for(size_t count) noexcept
+			{
+				size_t cap{ GROUP_SIZE };
+				while (cap * 7 < count * 8)
+				{
+					cap *= 2;
+				}
+				return cap;
+			}
+
+			//Bit i is set for every control byte in the group equal to value
+			[[nodiscard]] static uint32_t match_byte(const int8_t* group, int8_t value) noexcept
+			{
+#if defined(SPARSE_STORAGE_SSE2)
+				__m128i const ctrl{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(group)) };
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value))));
+#else
+				uint32_t mask{ 0 };
+				for (uint32_t i{ 0 }; i < GROUP_SIZE; ++i)
+				{
+					mask |= static_cast<uint32_t>(group[i] == value) << i;
+				}
+				return mask;
+#endif
+			}
+
+			//Bit i is set for every empty or deleted slot in the group, both have the sign bit set
+			[[nodiscard]] static uint32_t match_free(const int8_t* group) noexcept
+			{
+#if defined(SPARSE_STORAGE_SSE2)
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group))));
+#else
+				uint32_t mask{ 0 };
+				for (uint32_t i{ 0 }; i < GROUP_SIZE; ++i)
+				{
+					mask |= static_cast<uint32_t>(group[i] < 0) << i;
+				}
+				return mask;
+#endif
+			}
+
+			[[nodiscard]] size_t find(KeyType key) const noexcept
+			{
+				if (m_Slots.empty())
+				{
+					return NOT_FOUND;
+				}
+
+				uint64_t const h{ hash(key) };
+				size_t const mask{ group_mask() };
+				size_t group{ static_cast<size_t>(h >> 7) & mask };
+
+				for (size_t step{ 1 }; ; ++step)
+				{
+					const int8_t* ctrl{ m_Ctrl.data() + group * GROUP_SIZE };
+					for (uint32_t match{ match_byte(ctrl, tag(h)) }; match != 0; match &= match - 1)
+					{
+						size_t const slot{ group * GROUP_SIZE + static_cast<size_t>(std::countr_zero(match)) };
+						if (m_Slots[slot].key == key)
+						{
+							return slot;
+						}
+					}
+
+					if (match_byte(ctrl, EMPTY) != 0)
+					{
+						return NOT_FOUND;
+					}
+					group = (group + step) & mask;
+				}
+			}
+
+			//Key must not be in the storage and the load must leave a free slot
+			void insert_new(KeyType key, DenseType index) noexcept
+			{
+				uint64_t const h{ hash(key) };
+				size_t const mask{ group_mask() };
+				size_t group{ static_cast<size_t>(h >> 7) & mask };
+
+				for (size_t step{ 1 }; ; ++step)
+				{
+					if (uint32_t const free{ match_free(m_Ctrl.data() + group * GROUP_SIZE) }; free != 0)
+					{
+						size_t const slot{ group * GROUP_SIZE + static_cast<size_t>(std::countr_zero(free)) };
+						if (m_Ctrl[slot] == DELETED)
+						{
+							--m_Deleted;
+						}
+
+						m_Ctrl[slot] = tag(h);
+						m_Slots[slot] = slot_type{ key, index };
+						++m_Count;
+						return;
+					}
+					group = (group + step) & mask;
+				}
+			}
+
+			void rehash(size_t newCap) noexcept
+			{
+				ctrl_container oldCtrl(newCap, EMPTY, m_Ctrl.get_allocator());
+				slot_container oldSlots(newCap, slot_type{ }, m_Slots.get_allocator());
+				oldCtrl.swap(m_Ctrl);
+				oldSlots.swap(m_Slots);
+
+				m_Count = 0;
+				m_Deleted = 0;
+				for (size_t slot{ 0 }; slot < oldSlots.size(); ++slot)
+				{
+					if (oldCtrl[slot] >= 0)
+					{
+						insert_new(oldSlots[slot].key, oldSlots[slot].index);
+					}
+				}
+			}
+		};
+
+		//Starts as a flat array and switches to a hash table once the keys get too spread out, and back once they are dense again.
+		//The flat array may hold up to MaxSpread slots per live key (and always MIN_FLAT_SIZE), the switch back waits for half of that
+		//so a set near the threshold does not flip on every emplace. Switching rebuilds the storage, it only happens inside emplace and shrink_to_fit.
+		template<typename KeyType, typename DenseType, size_t MaxSpread, typename Allocator = std::allocator<DenseType>>
+		class adaptive_sparse_storage final
+		{
+			using flat_storage = flat_sparse_storage<KeyType, DenseType, Allocator>;
+			using hashed_storage = hashed_sparse_storage<KeyType, DenseType, Allocator>;
+
+		public:
+			using key_type = KeyType;
+			using dense_type = DenseType;
+			using allocator_type = Allocator;
+
+			static constexpr DenseType INVALID_INDEX = std::numeric_limits<DenseType>::max();
+			static constexpr size_t MIN_FLAT_SIZE{ 4096 };
+
+			adaptive_sparse_storage() noexcept = default;
+			explicit adaptive_sparse_storage(const Allocator& alloc) noexcept :
+				m_Flat{ alloc },
+				m_Hashed{ alloc }
+			{ }
+			explicit adaptive_sparse_storage(size_t size, const Allocator& alloc = Allocator{ }) noexcept :
+				adaptive_sparse_storage{ alloc }
+			{
+				resize(size);
+			}
+
+		public:
+			[[nodiscard]] bool contains(KeyType key) const noexcept
+			{
+				return m_IsHashed ? m_Hashed.contains(key) : m_Flat.contains(key);
+			}
+
+			//Returns INVALID_INDEX when the key is not in the storage
+			[[nodiscard]] DenseType get(KeyType key) const noexcept
+			{
+				return m_IsHashed ? m_Hashed.get(key) : m_Flat.get(key);
+			}
+
+			void get_many(const KeyType* keys, size_t count, DenseType* out) const noexcept
+			{
+				if (m_IsHashed)
+				{
+					m_Hashed.get_many(keys, count, out);
+				}
+				else
+				{
+					m_Flat.get_many(keys, count, out);
+				}
+			}
+
+			//Key must be in the storage
+			DenseType& operator[](KeyType key) noexcept
+			{
+				return m_IsHashed ? m_Hashed[key] : m_Flat[key];
+			}
+			DenseType const& operator[](KeyType key) const noexcept
+			{
+				return m_IsHashed ? m_Hashed[key] : m_Flat[key];
+			}
+
+			void emplace(KeyType key, DenseType index) noexcept
+			{
+				if (m_IsHashed)
+				{
+					m_Hashed.emplace(key, index);
+					if (m_Hashed.count() != m_Count)
+					{
+						m_Count = m_Hashed.count();
+						m_MaxKey = std::max(m_MaxKey, key);
+
+						if (fits_flat(m_MaxKey, m_Count / 2))
+						{
+							to_flat();
+						}
+					}
+					return;
+				}
+
+				if (key >= m_Flat.size() && !fits_flat(key, m_Count + 1))
+				{
+					to_hashed();
+					emplace(key, index);
+					return;
+				}
+
+				if (!m_Flat.contains(key))
+				{
+					++m_Count;
+					m_MaxKey = std::max(m_MaxKey, key);
+				}
+				m_Flat.emplace(key, index);
+			}
+
+			void release(KeyType key) noexcept
+			{
+				if (m_IsHashed)
+				{
+					m_Hashed.release(key);
+				}
+				else
+				{
+					m_Flat.release(key);
+				}
+				--m_Count;
+			}
+
+		public:
+			[[nodiscard]] size_t size() const noexcept { return m_IsHashed ? m_Hashed.size() : m_Flat.size(); }
+
+			//Number of keys in the storage
+			[[nodiscard]] size_t count() const noexcept { return m_Count; }
+
+			[[nodiscard]] bool is_hashed() const noexcept { return m_IsHashed; }
+
+			//Bytes of both representations, a switch releases the one that is no longer used
+			[[nodiscard]] size_t memory_usage() const noexcept { return m_Flat.memory_usage() + m_Hashed.memory_usage(); }
+
+			//Only grows the flat array while the keys would stay dense enough, emplace takes care of the rest
+			void resize(size_t newSize) noexcept
+			{
+				if (!m_IsHashed && newSize > 0 && fits_flat(static_cast<uint64_t>(newSize - 1), m_Count))
+				{
+					m_Flat.resize(newSize);
+				}
+			}
+
+			void reserve(size_t newCap) noexcept
+			{
+				if (!m_IsHashed && newCap > 0 && fits_flat(static_cast<uint64_t>(newCap - 1), m_Count))
+				{
+					m_Flat.reserve(newCap);
+				}
+			}
+
+			//Picks the representation that suits the live keys, then releases the unused memory
+			void shrink_to_fit() noexcept
+			{
+				m_MaxKey = 0;
+				for_each_key([this](KeyType key) { m_MaxKey = std::max(m_MaxKey, key); });
+
+				if (m_IsHashed && fits_flat(m_MaxKey, m_Count))
+				{
+					to_flat();
+				}
+				else if (!m_IsHashed && !fits_flat(m_MaxKey, m_Count))
+				{
+					to_hashed();
+				}
+
+				if (m_IsHashed)
+				{
+					m_Hashed.shrink_to_fit();
+					return;
+				}
+
+				m_Flat.resize(m_Count > 0 ? static_cast<size_t>(m_MaxKey) + 1 : 0);
+				m_Flat.shrink_to_fit();
+			}
+
+			void clear() noexcept
+			{
+				if (m_IsHashed)
+				{
+					m_Hashed.clear();
+				}
+				else
+				{
+					m_Flat.clear();
+				}
+				m_Count = 0;
+				m_MaxKey = 0;
+			}
+
+			[[nodiscard]] allocator_type get_allocator() const noexcept { return m_Flat.get_allocator(); }
+
+		private:
+			flat_storage m_Flat{ };
+			hashed_storage m_Hashed{ };
+
+			size_t m_Count{ 0 };
+			//Upper bound of the live keys, exact again after a switch or shrink_to_fit
+			KeyType m_MaxKey{ 0 };
+			bool m_IsHashed{ false };
+
+			[[nodiscard]] static constexpr bool fits_flat(uint64_t maxKey, size_t count) noexcept
+			{
+				return maxKey < std::max<uint64_t>(MIN_FLAT_SIZE, static_cast<uint64_t>(count) * MaxSpread);
+			}
+
+			template<typename Func>
+			void for_each_key(Func&& func) const
+			{
+				if (m_IsHashed)
+				{
+					m_Hashed.each([&func](KeyType key, DenseType) { func(key); });
+					return;
+				}
+
+				auto const& arr{ m_Flat.data() };
+				for (size_t key{ 0 }; key < arr.size(); ++key)
+				{
+					if (arr[key] != INVALID_INDEX)
+					{
+						func(static_cast<KeyType>(key));
+					}
+				}
+			}
+
+			void to_hashed() noexcept
+			{
+				m_Hashed.clear();
+				m_Hashed.reserve(m_Count + 1);
+
+				auto const& arr{ m_Flat.data() };
+				for (size_t key{ 0 }; key < arr.size(); ++key)
+				{
+					if (arr[key] != INVALID_INDEX)
+					{
+						m_Hashed.emplace(static_cast<KeyType>(key), arr[key]);
+					}
+				}
+
+				m_Flat = flat_storage{ m_Flat.get_allocator() };
+				m_IsHashed = true;
+			}
+
+			void to_flat() noexcept
+			{
+				m_MaxKey = 0;
+				m_Hashed.each([this](KeyType key, DenseType) { m_MaxKey = std::max(m_MaxKey, key); });
+
+				m_Flat.clear();
+				m_Flat.resize(m_Count > 0 ? static_cast<size_t>(m_MaxKey) + 1 : 0);
+				m_Hashed.each([this](KeyType key, DenseType index) { m_Flat.emplace(key, index); });
+
+				m_Hashed.clear();
+				m_Hashed.shrink_to_fit();
+				m_IsHashed = false;
+			}
+		};
+
+		enum class bitset_op
+		{
+			intersection,
+			unite,
+			difference
+		};
+
+		//One bit per key in leaf words, plus one summary bit per leaf word that is set while the leaf word has any bit set.
+		//Traversal and the set operations skip every summary word that is zero, so empty regions of 4096 keys cost one load.
+		template<typename Allocator = std::allocator<uint64_t>>
+		class hierarchical_bitset final
+		{
+		public:
+			using allocator_type = Allocator;
+			using word_container = std::vector<uint64_t, Allocator>;
+
+			static constexpr size_t WORD_BITS{ 64 };
+
+			hierarchical_bitset() noexcept = default;
+			explicit hierarchical_bitset(const Allocator& alloc) noexcept :
+				m_Leaves(alloc),
+				m_Summary(alloc)
+			{ }
+
+		public:
+			[[nodiscard]] bool test(size_t bit) const noexcept
+			{
+				size_t const word{ bit / WORD_BITS };
+				return word < m_Leaves.size() && ((m_Leaves[word] >> (bit % WORD_BITS)) & 1) != 0;
+			}
+
+			void set(size_t bit) noexcept
+			{
+				size_t const word{ bit / WORD_BITS };
+				if (word >= m_Leaves.size())
+				{
+					resize(bit + 1);
+				}
+
+				m_Leaves[word] |= uint64_t{ 1 } << (bit % WORD_BITS);
+				m_Summary[word / WORD_BITS] |= uint64_t{ 1 } << (word % WORD_BITS);
+			}
+
+			void reset(size_t bit) noexcept
+			{
+				size_t const word{ bit / WORD_BITS };
+				if (word >= m_Leaves.size())
+				{
+					return;
+				}
+
+				m_Leaves[word] &= ~(uint64_t{ 1 } << (bit % WORD_BITS));
+				if (m_Leaves[word] == 0)
+				{
+					m_Summary[word / WORD_BITS] &= ~(uint64_t{ 1 } << (word % WORD_BITS));
+				}
+			}
+
+			//Calls func(bit) for every set bit in ascending order
+			template<typename Func>
+			void each(Func&& func) const
+			{
+				for (size_t block{ 0 }; block < m_Summary.size(); ++block)
+				{
+					for (uint64_t words{ m_Summary[block] }; words != 0; words &= words - 1)
+					{
+						size_t const word{ block * WORD_BITS + static_cast<size_t>(std::countr_zero(words)) };
+						for (uint64_t bits{ m_Leaves[word] }; bits != 0; bits &= bits - 1)
+						{
+							func(word * WORD_BITS + static_cast<size_t>(std::countr_zero(bits)));
+						}
+					}
+				}
+			}
+
+			//Amount of set bits
+			[[nodiscard]] size_t count() const noexcept
+			{
+				size_t total{ 0 };
+				each_word([&total](size_t, uint64_t bits) { total += static_cast<size_t>(std::popcount(bits)); });
+				return total;
+			}
+
+			[[nodiscard]] bool empty() const noexcept
+			{
+				return std::all_of(m_Summary.begin(), m_Summary.end(), [](uint64_t words) { return words == 0; });
+			}
+
+			const word_container& leaves() const noexcept { return m_Leaves; }
+			const word_container& summary() const noexcept { return m_Summary; }
+
+		public:
+			//Number of bits that can be set without growing
+			[[nodiscard]] size_t size() const noexcept { return m_Leaves.size() * WORD_BITS; }
+
+			//Bytes of both levels
+			[[nodiscard]] size_t memory_usage() const noexcept { return (m_Leaves.capacity() + m_Summary.capacity()) * sizeof(uint64_t); }
+
+			void resize(size_t bits) noexcept
+			{
+				size_t const words{ (bits + WORD_BITS - 1) / WORD_BITS };
+				m_Leaves.resize(words, 0);
+				m_Summary.resize((words + WORD_BITS - 1) / WORD_BITS, 0);
+			}
+
+			void reserve(size_t bits) noexcept
+			{
+				size_t const words{ (bits + WORD_BITS - 1) / WORD_BITS };
+				m_Leaves.reserve(words);
+				m_Summary.reserve((words + WORD_BITS - 1) / WORD_BITS);
+			}
+
+			void shrink_to_fit() noexcept
+			{
+				while (!m_Leaves.empty() && m_Leaves.back() == 0)
+				{
+					m_Leaves.pop_back();
+				}
+				m_Summary.resize((m_Leaves.size() + WORD_BITS - 1) / WORD_BITS);
+
+				m_Leaves.shrink_to_fit();
+				m_Summary.shrink_to_fit();
+			}
+
+			void clear() noexcept
+			{
+				m_Leaves.clear();
+				m_Summary.clear();
+			}
+
+			[[nodiscard]] allocator_type get_allocator() const noexcept { return m_Leaves.get_allocator(); }
+
+		public:
+			//Bits set in both, only the leaf words under a summary bit of both sides are touched
+			template<typename OtherAllocator>
+			[[nodiscard]] static hierarchical_bitset intersection(const hierarchical_bitset& a, const hierarchical_bitset<OtherAllocator>& b)
+			{
+				return combine<bitset_op::intersection>(a, b);
+			}
+
+			//Bits set in either
+			template<typename OtherAllocator>
+			[[nodiscard]] static hierarchical_bitset unite(const hierarchical_bitset& a, const hierarchical_bitset<OtherAllocator>& b)
+			{
+				return combine<bitset_op::unite>(a, b);
+			}
+
+			//Bits set in a but not in b
+			template<typename OtherAllocator>
+			[[nodiscard]] static hierarchical_bitset difference(const hierarchical_bitset& a, const hierarchical_bitset<OtherAllocator>& b)
+			{
+				return combine<bitset_op::difference>(a, b);
+			}
+
+		private:
+			word_container m_Leaves{ };
+			word_container m_Summary{ };
+
+			//Calls func(wordIndex, bits) for every leaf word that is not zero
+			template<typename Func>
+			void each_word(Func&& func) const
+			{
+				for (size_t block{ 0 }; block < m_Summary.size(); ++block)
+				{
+					for (uint64_t words{ m_Summary[block] }; words != 0; words &= words - 1)
+					{
+						size_t const word{ block * WORD_BITS + static_cast<size_t>(std::countr_zero(words)) };
+						func(word, m_Leaves[word]);
+					}
+				}
+			}
+
+			template<bitset_op Op>
+			[[nodiscard]] static constexpr uint64_t apply(uint64_t a, uint64_t b) noexcept
+			{
+				if constexpr (Op == bitset_op::intersection)
+				{
+					return a & b;
+				}
+				else if constexpr (Op == bitset_op::unite)
+				{
+					return a | b;
+				}
+				else
+				{
+					return a & ~b;
+				}
+			}
+
+			//Combines the words [begin, end) of a and b into out, both inputs must cover the range
+			template<bitset_op Op>
+			static void apply_words(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t begin, size_t end) noexcept
+			{
+				size_t i{ begin };
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+				for (; i + 4 <= end; i += 4)
+				{
+					__m256i const x{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)) };
+					__m256i const y{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)) };
+
+					__m256i result{ };
+					if constexpr (Op == bitset_op::intersection)
+					{
+						result = _mm256_and_si256(x, y);
+					}
+					else if constexpr (Op == bitset_op::unite)
+					{
+						result = _mm256_or_si256(x, y);
+					}
+					else
+					{
+						result = _mm256_andnot_si256(y, x);
+					}
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+				}
+#endif
+
+				for (; i < end; ++i)
+				{
+					out[i] = apply<Op>(a[i], b[i]);
+				}
+			}
+
+			template<bitset_op Op, typename OtherAllocator>
+			[[nodiscard]] static hierarchical_bitset combine(const hierarchical_bitset& a, const hierarchical_bitset<OtherAllocator>& b)
+			{
+				auto const& aLeaves{ a.leaves() };
+				auto const& bLeaves{ b.leaves() };
+				auto const& aSummary{ a.summary() };
+				auto const& bSummary{ b.summary() };
+
+				size_t words{ aLeaves.size() };
+				if constexpr (Op == bitset_op::intersection)
+				{
+					words = std::min(aLeaves.size(), bLeaves.size());
+				}
+				else if constexpr (Op == bitset_op::unite)
+				{
+					words = std::max(aLeaves.size(), bLeaves.size());
+				}
+
+				hierarchical_bitset result{ a.get_allocator() };
+				result.resize(words * WORD_BITS);
+
+				for (size_t block{ 0 }; block < result.m_Summary.size(); ++block)
+				{
+					uint64_t const aWords{ block < aSummary.size() ? aSummary[block] : 0 };
+					uint64_t const bWords{ block < bSummary.size() ? bSummary[block] : 0 };
+					if ((Op == bitset_op::difference ? aWords : apply<Op>(aWords, bWords)) == 0)
+					{
+						continue;
+					}
+
+					size_t const begin{ block * WORD_BITS };
+					size_t const end{ std::min(begin + WORD_BITS, words) };
+
+					//A side that ends inside the block reads as zero words past its end
+					size_t const shared{ std::clamp(std::min(aLeaves.size(), bLeaves.size()), begin, end) };
+					apply_words<Op>(aLeaves.data(), bLeaves.data(), result.m_Leaves.data(), begin, shared);
+					for (size_t word{ shared }; word < end; ++word)
+					{
+						result.m_Leaves[word] = apply<Op>(word < aLeaves.size() ? aLeaves[word] : 0, word < bLeaves.size() ? bLeaves[word] : 0);
+					}
+
+					uint64_t summary{ 0 };
+					for (size_t word{ begin }; word < end; ++word)
+					{
+						summary |= static_cast<uint64_t>(result.m_Leaves[word] != 0) << (word - begin);
+					}
+					result.m_Summary[block] = summary;
+				}
+
+				return result;
+			}
+		};
+
+		//Wraps another sparse storage and keeps a hierarchical presence bitset of its keys next to it.
+		//contains only tests a bit, the wrapped storage is only read for the dense index.
+		template<typename Storage, typename Allocator>
+		class bitset_sparse_storage final
+		{
+			using presence_type = hierarchical_bitset<typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t>>;
+
+		public:
+			using key_type = typename Storage::key_type;
+			using dense_type = typename Storage::dense_type;
+			using allocator_type = Allocator;
+			using storage_type = Storage;
+
+			static constexpr dense_type INVALID_INDEX = std::numeric_limits<dense_type>::max();
+
+			bitset_sparse_storage() noexcept = default;
+			explicit bitset_sparse_storage(const Allocator& alloc) noexcept :
+				m_Storage{ alloc },
+				m_Presence{ typename presence_type::allocator_type{ alloc } }
+			{ }
+			explicit bitset_sparse_storage(size_t size, const Allocator& alloc = Allocator{ }) noexcept :
+				bitset_sparse_storage{ alloc }
+			{
+				resize(size);
+			}
+
+		public:
+			[[nodiscard]] bool contains(key_type key) const noexcept
+			{
+				return m_Presence.test(static_cast<size_t>(key));
+			}
+
+			//Returns INVALID_INDEX when the key is not in the storage
+			[[nodiscard]] dense_type get(key_type key) const noexcept
+			{
+				return m_Storage.get(key);
+			}
+
+			void get_many(const key_type* keys, size_t count, dense_type* out) const noexcept
+			{
+				m_Storage.get_many(keys, count, out);
+			}
+
+			//Key must be in the storage
+			dense_type& operator[](key_type key) noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return m_Storage[key];
+			}
+			dense_type const& operator[](key_type key) const noexcept
+			{
+				ASSERT(contains(key), "Key not in sparse storage!");
+				return m_Storage[key];
+			}
+
+			void emplace(key_type key, dense_type index) noexcept
+			{
+				m_Storage.emplace(key, index);
+				m_Presence.set(static_cast<size_t>(key));
+			}
+
+			void release(key_type key) noexcept
+			{
+				m_Storage.release(key);
+				m_Presence.reset(static_cast<size_t>(key));
+			}
+
+		public:
+			[[nodiscard]] size_t size() const noexcept { return m_Storage.size(); }
+
+			//Bytes of the storage and the presence bitset
+			[[nodiscard]] size_t memory_usage() const noexcept { return m_Storage.memory_usage() + m_Presence.memory_usage(); }
+
+			void resize(size_t newSize) noexcept
+			{
+				m_Storage.resize(newSize);
+				if (newSize > m_Presence.size())
+				{
+					m_Presence.resize(newSize);
+				}
+			}
+
+			void reserve(size_t newCap) noexcept
+			{
+				m_Storage.reserve(newCap);
+				m_Presence.reserve(newCap);
+			}
+
+			void shrink_to_fit() noexcept
+			{
+				m_Storage.shrink_to_fit();
+				m_Presence.shrink_to_fit();
+			}
+
+			void clear() noexcept
+			{
+				m_Storage.clear();
+				m_Presence.clear();
+			}
+
+			const presence_type& presence() const noexcept { return m_Presence; }
+			const storage_type& storage() const noexcept { return m_Storage; }
+
+			[[nodiscard]] allocator_type get_allocator() const noexcept { return m_Storage.get_allocator(); }
+
+		private:
+			Storage m_Storage{ };
+			presence_type m_Presence{ };
+		};
+	}
+
+	//Sparse storage policies, select how sparse_set maps keys onto dense indices.
+
+	//One contiguous array indexed by key, fastest lookup but memory scales with the largest key.
+	//Growth decides how the array grows and whether it trims itself once the large keys are gone, e.g. geometric_growth<3, 2, 25>.
+	template<Impl::GrowthPolicy Growth = geometric_growth<>>
+	struct basic_flat_sparse final
+	{
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>>
+		using storage_type = Impl::flat_sparse_storage<KeyType, DenseType, Allocator, Growth>;
+	};
+
+	//Default policy
+	using flat_sparse = basic_flat_sparse<>;
+
+	//Lazily allocated fixed size pages found through a block directory, memory scales with the live keys. Use for large, scattered key spaces.
+	template<size_t PageSize = 4096>
+	struct paged_sparse final
+	{
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>>
+		using storage_type = Impl::paged_sparse_storage<KeyType, DenseType, PageSize, Allocator>;
+	};
+
+	//Hash table from key to dense index, for huge key spaces like 64 bit hashed ids where even pages would be mostly empty.
+	//Lookups cost a hash and a group probe instead of a single load.
+	struct hashed_sparse final
+	{
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>>
+		using storage_type = Impl::hashed_sparse_storage<KeyType, DenseType, Allocator>;
+	};
+
+	//Flat array while the keys are dense, hash table once there are more than MaxSpread sparse slots per live key.
+	//Use when one set type has to cover both dense and scattered keys.
+	template<size_t MaxSpread = 8>
+	struct adaptive_sparse final
+	{
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>>
+		using storage_type = Impl::adaptive_sparse_storage<KeyType, DenseType, MaxSpread, Allocator>;
+	};
+
+	//Adds a hierarchical presence bitset of the keys on top of another policy, one bit per key of the key space.
+	//Enables the set algebra and key ordered traversal of sparse_set, do not combine with hashed_sparse for huge key spaces.
+	template<typename Inner = flat_sparse>
+	struct bitset_sparse final
+	{
+		template<typename KeyType, typename DenseType, typename Allocator = std::allocator<DenseType>>
+		using storage_type = Impl::bitset_sparse_storage<typename Inner::template storage_type<KeyType, DenseType, Allocator>, Allocator>;
+	};
+
+	namespace Impl
+	{
+		//True for every flat policy, the only ones that store one contiguous sparse array
+		template<typename P>
+		inline constexpr bool is_flat_sparse_v{ false };
+		template<typename Growth>
+		inline constexpr bool is_flat_sparse_v<basic_flat_sparse<Growth>>{ true };
+	}
+}
+
+#endif
@@ -0,0 +1,409 @@
+#ifndef STABLE_SPARSE_SET
+#define STABLE_SPARSE_SET
+
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <type_traits>
+#include <limits>
+#include <utility>
+#include <functional>
+
+#include "SparseSet.h"
+
+namespace Internal
+{
+	//sparse_set variant where erase leaves a tombstone instead of moving the last element into the hole,
+	//so the dense index of every other element stays valid until compact() is called.
+	//Tombstones form a free list through their dense slots that emplace reuses, iteration skips them.
+	//Keys can not exceed max_sparse_size(), the top bit of a dense slot marks a tombstone.
+	template<Impl::ValType Val, Impl::KeyType KeyType = uint32_t, Impl::SparsePolicy<KeyType> SparsePolicy = flat_sparse, typename Allocator = std::allocator<Val>>
+	class stable_sparse_set final
+	{
+		using alloc_traits = std::allocator_traits<Allocator>;
+
+		template<typename T>
+		using rebind_alloc = typename alloc_traits::template rebind_alloc<T>;
+
+	public:
+		template<bool IsConst, bool WithKeys>
+		class basic_iterator;
+
+		using key_type = KeyType;
+		using dense_type = KeyType;
+		using value_type = Val;
+		using sparse_policy = SparsePolicy;
+		using allocator_type = Allocator;
+		using sparse_storage = typename SparsePolicy::template storage_type<KeyType, dense_type, rebind_alloc<dense_type>>;
+		using dense_container = std::vector<KeyType, rebind_alloc<KeyType>>;
+		using packed_container = std::vector<Val, Allocator>;
+
+		//Yield Val&
+		using iterator = basic_iterator<false, false>;
+		using const_iterator = basic_iterator<true, false>;
+
+		//Yield (key, Val&) pairs
+		using item_iterator = basic_iterator<false, true>;
+		using const_item_iterator = basic_iterator<true, true>;
+
+		stable_sparse_set() noexcept = default;
+
+		explicit stable_sparse_set(const Allocator& alloc) noexcept :
+			m_SparseArr(rebind_alloc<KeyType>{ alloc }),
+			m_DenseArr(rebind_alloc<KeyType>{ alloc }),
+			m_PackedValArr(alloc)
+		{ }
+
+		stable_sparse_set(KeyType sparseSize, KeyType reserveSize = 0, const Allocator& alloc = Allocator{ }) noexcept :
+			stable_sparse_set(alloc)
+		{
+			m_SparseArr.resize(sparseSize);
+			reserve(reserveSize);
+		}
+
+		~stable_sparse_set() noexcept = default;
+
+		stable_sparse_set(const stable_sparse_set&) noexcept = default;
+		stable_sparse_set& operator=(const stable_sparse_set&) noexcept = default;
+		stable_sparse_set(stable_sparse_set&&) noexcept = default;
+		stable_sparse_set& operator=(stable_sparse_set&&) noexcept = default;
+
+	public:
+		template<bool IsConst, bool WithKeys>
+		class basic_iterator final
+		{
+			using set_type = std::conditional_t<IsConst, const stable_sparse_set, stable_sparse_set>;
+			using value_ref = std::conditional_t<IsConst, Val const&, Val&>;
+
+		public:
+			using iterator_category = std::bidirectional_iterator_tag;
+			using difference_type = std::ptrdiff_t;
+			using value_type = std::conditional_t<WithKeys, std::pair<KeyType, value_ref>, Val>;
+			using reference = std::conditional_t<WithKeys, value_type, value_ref>;
+			using pointer = void;
+
+			basic_iterator() noexcept = default;
+			basic_iterator(set_type* set, size_t pos) noexcept :
+				m_Set{ set },
+				m_Pos{ pos }
+			{
+				skip_forward();
+			}
+
+			[[nodiscard]] reference operator*() const noexcept
+			{
+				if constexpr (WithKeys)
+				{
+					return { m_Set->m_DenseArr[m_Pos], m_Set->m_PackedValArr[m_Pos] };
+				}
+				else
+				{
+					return m_Set->m_PackedValArr[m_Pos];
+				}
+			}
+
+			basic_iterator& operator++() noexcept
+			{
+				++m_Pos;
+				skip_forward();
+				return *this;
+			}
+			basic_iterator operator++(int) noexcept { basic_iterator const temp{ *this }; ++(*this); return temp; }
+
+			basic_iterator& operator--() noexcept
+			{
+				do
+				{
+					--m_Pos;
+				} while (is_tombstone(m_Set->m_DenseArr[m_Pos]));
+				return *this;
+			}
+			basic_iterator operator--(int) noexcept { basic_iterator const temp{ *this }; --(*this); return temp; }
+
+			[[nodiscard]] bool operator==(const basic_iterator& other) const noexcept { return m_Pos == other.m_Pos; }
+
+			//Stable dense index of the element
+			[[nodiscard]] size_t index() const noexcept { return m_Pos; }
+
+		private:
+			set_type* m_Set{ nullptr };
+			size_t m_Pos{ 0 };
+
+			void skip_forward() noexcept
+			{
+				auto const& dense{ m_Set->m_DenseArr };
+				while (m_Pos < dense.size() && is_tombstone(dense[m_Pos]))
+				{
+					++m_Pos;
+				}
+			}
+		};
+
+		iterator begin() noexcept { return iterator{ this, 0 }; }
+		iterator end() noexcept { return iterator{ this, m_DenseArr.size() }; }
+		const_iterator begin() const noexcept { return const_iterator{ this, 0 }; }
+		const_iterator end() const noexcept { return const_iterator{ this, m_DenseArr.size() }; }
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		//(key, Val&) pairs of the live elements in dense order
+		[[nodiscard]] std::ranges::subrange<item_iterator> items() noexcept
+		{
+			return { item_iterator{ this, 0 }, item_iterator{ this, m_DenseArr.size() } };
+		}
+		[[nodiscard]] std::ranges::subrange<const_item_iterator> items() const noexcept
+		{
+			return { const_item_iterator{ this, 0 }, const_item_iterator{ this, m_DenseArr.size() } };
+		}
+
+	public:
+		//Amount of live elements
+		[[nodiscard]] size_t size() const noexcept { return m_DenseArr.size() - m_TombstoneCount; }
+		[[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+		//Amount of dense slots, live elements and tombstones
+		[[nodiscard]] size_t slot_count() const noexcept { return m_DenseArr.size(); }
+		[[nodiscard]] size_t tombstone_count() const noexcept { return m_TombstoneCount; }
+		[[nodiscard]] size_t sparse_size() const noexcept { return m_SparseArr.size(); }
+
+		[[nodiscard]] static constexpr KeyType max_sparse_size() noexcept
+		{
+			return TOMBSTONE_BIT - 1;
+		}
+
+		void sparse_reserve(KeyType newCap) noexcept
+		{
+			m_SparseArr.reserve(newCap);
+		}
+
+		void reserve(KeyType newCap) noexcept
+		{
+			m_DenseArr.reserve(newCap);
+			m_PackedValArr.reserve(newCap);
+		}
+
+		void shrink_to_fit() noexcept
+		{
+			m_SparseArr.shrink_to_fit();
+			m_DenseArr.shrink_to_fit();
+			m_PackedValArr.shrink_to_fit();
+		}
+
+		void clear() noexcept
+		{
+			m_DenseArr.clear();
+			m_PackedValArr.clear();
+			m_SparseArr.clear();
+
+			m_FreeHead = FREE_LIST_END;
+			m_TombstoneCount = 0;
+		}
+
+		//Tombstone slots hold a free list link, use is_live to tell them apart
+		const dense_container& dense() const noexcept { return m_DenseArr; }
+		//Tombstone slots hold a moved from value
+		const packed_container& data() const noexcept { return m_PackedValArr; }
+
+		[[nodiscard]] bool is_live(size_t index) const noexcept
+		{
+			ASSERT(index < m_DenseArr.size(), "Index out of the dense slots!");
+			return !is_tombstone(m_DenseArr[index]);
+		}
+
+		[[nodiscard]] allocator_type get_allocator() const noexcept { return m_PackedValArr.get_allocator(); }
+
+	public:
+		[[nodiscard]] bool contains(KeyType element) const noexcept
+		{
+			ASSERT(element <= max_sparse_size(), "Element must be a valid index!");
+			return m_SparseArr.contains(element);
+		}
+
+		//Element must exist to get a valid value, stays valid until the element is erased or the set is compacted
+		[[nodiscard]] KeyType index(KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_SparseArr[element];
+		}
+
+		//Element must exist to get a valid value
+		Val& operator[](KeyType element) noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_PackedValArr[m_SparseArr[element]];
+		}
+		Val const& operator[](KeyType element) const noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+			return m_PackedValArr[m_SparseArr[element]];
+		}
+
+		//Random access with bounds checking (similar to std::vector:::at())
+		Val const& at(KeyType element) const
+		{
+			if (contains(element))
+			{
+				return m_PackedValArr[m_SparseArr[element]];
+			}
+			throw sparse_set_out_of_range("Element not found in stable_sparse_set", element);
+		}
+
+	public:
+		//Reuses the most recently freed slot, appends when there are no tombstones.
+		//Do not emplace the same element in the set twice, use try_emplace if this is a concern.
+		template<typename... Args>
+		requires std::is_constructible_v<Val, Args...>
+		Val& emplace(KeyType element, Args&&... args) noexcept
+		{
+			ASSERT(!contains(element), "Element already in set!");
+			ASSERT(element <= max_sparse_size(), "Element must be a valid index!");
+
+			if (m_FreeHead == FREE_LIST_END)
+			{
+				m_SparseArr.emplace(element, static_cast<KeyType>(m_DenseArr.size()));
+				m_DenseArr.emplace_back(element);
+				return m_PackedValArr.emplace_back(std::forward<Args>(args)...);
+			}
+
+			KeyType const slot{ m_FreeHead };
+			m_FreeHead = static_cast<KeyType>(m_DenseArr[slot] & ~TOMBSTONE_BIT);
+			--m_TombstoneCount;
+
+			m_SparseArr.emplace(element, slot);
+			m_DenseArr[slot] = element;
+			Impl::assign_value(m_PackedValArr[slot], Val(std::forward<Args>(args)...));
+			return m_PackedValArr[slot];
+		}
+
+		template<typename... Args>
+		requires std::is_constructible_v<Val, Args...>
+		std::pair<Val*, bool> try_emplace(KeyType element, Args&&... args) noexcept
+		{
+			if (contains(element))
+			{
+				return { &m_PackedValArr[m_SparseArr[element]], false };
+			}
+			return { &emplace(element, std::forward<Args>(args)...), true };
+		}
+
+		//Leaves a tombstone, no other element moves. Erasing the last slot shrinks the dense range instead.
+		//Do not erase an element that does not exist, use remove instead if this is a concern.
+		void erase(KeyType element) noexcept
+		{
+			ASSERT(contains(element), "Element not in set!");
+
+			KeyType const slot{ m_SparseArr[element] };
+			m_SparseArr.release(element);
+
+			if (slot + size_t{ 1 } == m_DenseArr.size())
+			{
+				m_DenseArr.pop_back();
+				m_PackedValArr.pop_back();
+				return;
+			}
+
+			if constexpr (!std::is_trivially_destructible_v<Val>)
+			{
+				//Releases what the value holds now instead of when the slot is reused
+				[[maybe_unused]] Val const dropped(std::move(m_PackedValArr[slot]));
+			}
+
+			m_DenseArr[slot] = static_cast<KeyType>(TOMBSTONE_BIT | m_FreeHead);
+			m_FreeHead = slot;
+			++m_TombstoneCount;
+		}
+
+		bool remove(KeyType element) noexcept
+		{
+			return contains(element) && (erase(element), true);
+		}
+
+		//Removes every tombstone in one pass, live elements keep their relative order.
+		//onMove(key, oldIndex, newIndex) is called for every element that changes dense index, to patch external tables.
+		template<typename OnMove>
+		requires std::is_invocable_v<OnMove&, KeyType, size_t, size_t>
+		void compact(OnMove&& onMove) noexcept
+		{
+			if (m_TombstoneCount == 0)
+			{
+				return;
+			}
+
+			size_t write{ 0 };
+			for (size_t read{ 0 }; read < m_DenseArr.size(); ++read)
+			{
+				if (is_tombstone(m_DenseArr[read]))
+				{
+					continue;
+				}
+
+				if (write != read)
+				{
+					Impl::assign_value(m_PackedValArr[write], std::move(m_PackedValArr[read]));
+					m_DenseArr[write] = m_DenseArr[read];
+					m_SparseArr[m_DenseArr[write]] = static_cast<KeyType>(write);
+					std::invoke(onMove, m_DenseArr[write], read, write);
+				}
+				++write;
+			}
+
+			m_DenseArr.resize(write);
+			while (m_PackedValArr.size() > write)
+			{
+				m_PackedValArr.pop_back();
+			}
+
+			m_FreeHead = FREE_LIST_END;
+			m_TombstoneCount = 0;
+		}
+		void compact() noexcept
+		{
+			compact([](KeyType, size_t, size_t) noexcept { });
+		}
+
+		//Calls func(key, Val&) for every live element in dense order
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val&>
+		void each(Func&& func)
+		{
+			for (size_t i{ 0 }; i < m_DenseArr.size(); ++i)
+			{
+				if (!is_tombstone(m_DenseArr[i]))
+				{
+					std::invoke(func, m_DenseArr[i], m_PackedValArr[i]);
+				}
+			}
+		}
+		template<typename Func>
+		requires std::is_invocable_v<Func&, KeyType, Val const&>
+		void each(Func&& func) const
+		{
+			for (size_t i{ 0 }; i < m_DenseArr.size(); ++i)
+			{
+				if (!is_tombstone(m_DenseArr[i]))
+				{
+					std::invoke(func, m_DenseArr[i], m_PackedValArr[i]);
+				}
+			}
+		}
+
+	private:
+		static constexpr KeyType TOMBSTONE_BIT{ static_cast<KeyType>(KeyType{ 1 } << (std::numeric_limits<KeyType>::digits - 1)) };
+		static constexpr KeyType FREE_LIST_END{ TOMBSTONE_BIT - 1 };
+
+		sparse_storage m_SparseArr{ };
+
+		dense_container m_DenseArr{ };
+		packed_container m_PackedValArr{ };
+
+		KeyType m_FreeHead{ FREE_LIST_END };
+		size_t m_TombstoneCount{ 0 };
+
+		[[nodiscard]] static constexpr bool is_tombstone(KeyType slot) noexcept
+		{
+			return (slot & TOMBSTONE_BIT) != 0;
+		}
+	};
+}
+
+#endif